@@ -0,0 +1,253 @@
+/* Compiler speed benchmark. Compile with cc -o ccbench ccbench.c and compare the
+   reported compile time, run it to check the generated code. */
+
+#include <stdio.h>
+
+#define N 8
+
+struct point {
+    int x;
+    int y;
+    float w;
+};
+
+int ma[N][N], mb[N][N], mc[N][N];
+int list[64];
+char text[64];
+struct point pts[16];
+float coef[6];
+
+int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int isqrt(int n) {
+    int r = 0, b = 1 << 30;
+    while (b > n)
+        b >>= 2;
+    while (b) {
+        if (n >= r + b) {
+            n -= r + b;
+            r = (r >> 1) + b;
+        } else
+            r >>= 1;
+        b >>= 2;
+    }
+    return r;
+}
+
+int popcount(int v) {
+    int c = 0;
+    while (v) {
+        v &= v - 1;
+        ++c;
+    }
+    return c;
+}
+
+int crc8(char* s, int n) {
+    int crc = 0, i, j;
+    for (i = 0; i < n; i++) {
+        crc ^= s[i];
+        for (j = 0; j < 8; j++)
+            if (crc & 0x80)
+                crc = ((crc << 1) ^ 0x07) & 0xff;
+            else
+                crc = (crc << 1) & 0xff;
+    }
+    return crc;
+}
+
+int rnd_seed;
+
+int rnd() {
+    rnd_seed = rnd_seed * 1103515245 + 12345;
+    return (rnd_seed >> 16) & 0x7fff;
+}
+
+void fill_list(int n) {
+    int i;
+    for (i = 0; i < n; i++)
+        list[i] = rnd() % 1000;
+}
+
+void sort_list(int n) {
+    int i, j, t;
+    for (i = 0; i < n - 1; i++)
+        for (j = 0; j < n - 1 - i; j++)
+            if (list[j] > list[j + 1]) {
+                t = list[j];
+                list[j] = list[j + 1];
+                list[j + 1] = t;
+            }
+}
+
+int check_list(int n) {
+    int i, sum = 0;
+    for (i = 1; i < n; i++) {
+        if (list[i - 1] > list[i])
+            return -1;
+        sum += list[i] * i;
+    }
+    return sum;
+}
+
+void mat_init() {
+    int i, j;
+    for (i = 0; i < N; i++)
+        for (j = 0; j < N; j++) {
+            ma[i][j] = i + j;
+            mb[i][j] = (i == j) ? 2 : i - j;
+        }
+}
+
+void mat_mul() {
+    int i, j, k, s;
+    for (i = 0; i < N; i++)
+        for (j = 0; j < N; j++) {
+            s = 0;
+            for (k = 0; k < N; k++)
+                s += ma[i][k] * mb[k][j];
+            mc[i][j] = s;
+        }
+}
+
+int mat_trace() {
+    int i, t = 0;
+    for (i = 0; i < N; i++)
+        t += mc[i][i];
+    return t;
+}
+
+float poly(float x) {
+    float r = 0.0;
+    int i;
+    for (i = 5; i >= 0; i--)
+        r = r * x + coef[i];
+    return r;
+}
+
+float fsqrt(float x) {
+    float g = x / 2.0;
+    int i;
+    for (i = 0; i < 10; i++)
+        g = (g + x / g) / 2.0;
+    return g;
+}
+
+void make_points() {
+    int i;
+    for (i = 0; i < 16; i++) {
+        pts[i].x = rnd() % 100 - 50;
+        pts[i].y = rnd() % 100 - 50;
+        pts[i].w = (float)(i + 1) / 4.0;
+    }
+}
+
+float centroid_x() {
+    float sx = 0.0, sw = 0.0;
+    int i;
+    for (i = 0; i < 16; i++) {
+        sx = sx + pts[i].w * (float)pts[i].x;
+        sw = sw + pts[i].w;
+    }
+    return sx / sw;
+}
+
+int farthest() {
+    int i, best = 0, d, bd = -1;
+    for (i = 0; i < 16; i++) {
+        d = pts[i].x * pts[i].x + pts[i].y * pts[i].y;
+        if (d > bd) {
+            bd = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void reverse(char* s) {
+    int i = 0, j = strlen(s) - 1;
+    char c;
+    while (i < j) {
+        c = s[i];
+        s[i++] = s[j];
+        s[j--] = c;
+    }
+}
+
+int to_int(char* s) {
+    int v = 0, neg = 0;
+    if (*s == '-') {
+        neg = 1;
+        ++s;
+    }
+    while (*s >= '0' && *s <= '9')
+        v = v * 10 + *s++ - '0';
+    return neg ? -v : v;
+}
+
+int classify(int c) {
+    switch (c) {
+    case ' ':
+    case '\t':
+        return 0;
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return 1;
+    default:
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+            return 2;
+        return 3;
+    }
+}
+
+int count_classes(char* s) {
+    int n[4], i;
+    for (i = 0; i < 4; i++)
+        n[i] = 0;
+    while (*s)
+        ++n[classify(*s++)];
+    return n[0] + n[1] * 10 + n[2] * 100 + n[3] * 1000;
+}
+
+int main() {
+    int i, sum = 0;
+    rnd_seed = 42;
+    for (i = 1; i < 50; i++)
+        sum += gcd(i * 7, 84) + isqrt(i * i + i) + popcount(i * 2654435761);
+    printf("integer   %d\n", sum);
+    strcpy(text, "The quick brown fox jumps over 13 lazy dogs!");
+    printf("crc8      %d\n", crc8(text, strlen(text)));
+    printf("classes   %d\n", count_classes(text));
+    reverse(text);
+    printf("reverse   %s\n", text);
+    printf("to_int    %d\n", to_int("-12345") + to_int("678"));
+    fill_list(64);
+    sort_list(64);
+    printf("sort      %d\n", check_list(64));
+    mat_init();
+    mat_mul();
+    printf("matrix    %d\n", mat_trace());
+    for (i = 0; i < 6; i++)
+        coef[i] = (float)(i + 1) / 3.0;
+    printf("poly      %f\n", poly(1.5));
+    printf("sqrt      %f\n", fsqrt(2.0));
+    make_points();
+    printf("centroid  %f\n", centroid_x());
+    printf("farthest  %d\n", farthest());
+    return 0;
+}
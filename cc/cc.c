@@ -11,11 +11,14 @@
 // clib functions
 #include <fcntl.h>
 #include <limits.h>
+#include <malloc.h>
 #include <math.h>
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // pico SDK hardware support functions
 #include <hardware/adc.h>
@@ -26,7 +29,11 @@
 #include <hardware/pwm.h>
 #include <hardware/spi.h>
 #include <hardware/sync.h>
+#include <hardware/timer.h>
 #include <hardware/uart.h>
+#if PICO_RP2350
+#include <hardware/structs/m33.h>
+#endif
 
 // pico SDK functions
 #include <pico/rand.h>
@@ -36,6 +43,7 @@
 // disassembler, compiler, and file system functions
 #include "armdisasm.h"
 #include "cc.h"
+#include "cc_lz.h"
 #include "cc_malloc.h"
 #include "cc_peep.h"
 #include "io.h"
@@ -49,11 +57,18 @@
 
 #define K 1024 // one kilobyte
 
-#define DATA_BYTES (16 * K)       // data segment size
-#define TEXT_BYTES (16 * K)       // code segment size
 #define TS_TBL_BYTES (2 * K)      // type size table size (released at run time)
 #define AST_TBL_BYTES (32 * K)    // abstract syntax table size (released at run time)
 #define MEMBER_DICT_BYTES (4 * K) // struct member table size (released at run time)
+#define SRC_BYTES (1 * K)         // source window size, bounds the source line length
+#define NAME_POOL_BYTES (1 * K)   // identifier name pool allocation unit
+#define HEAP_LISTS (16 * K)       // symbols, names, relocations and per function tables, at first
+// heap left to the compiler's tables, the rest is code and data. A compile that runs out is
+// retried with twice the reserve.
+#define HEAP_RESERVE (TS_TBL_BYTES + AST_TBL_BYTES + MEMBER_DICT_BYTES + SRC_BYTES + HEAP_LISTS)
+#define PROF_DEPTH 256            // deepest call nesting the profiler times
+#define SAMPLE_MAX 2048           // program counter samples kept while sampling
+#define SAMPLE_US 100             // initial sampling period in microseconds
 
 #define CTLC 3 // control C ascii character
 
@@ -65,18 +80,22 @@
 #define ADJ_BITS 5
 #define ADJ_MASK ((1 << ADJ_BITS) - 1)
 
+// callee saved registers available for local variables
+#if PICO_RP2350
+#define REG_VARS 7 // r4-r6, r8-r11
+#else
+#define REG_VARS 3 // r4-r6
+#endif
+
 // executable version
-#define CC_VERSION 0xc6
+#define CC_VERSION 0xcb
 
 // pshell common functions
 extern char* full_path(char* name);                  // expand file name to full path name
 extern int cc_printf(void* stk, int wrds, int prnt); // shim for printf and sprintf
 extern void get_screen_xy(int* x, int* y);           // retrieve screem dimensions
 extern void cc_exit(int rc);                         // C exit function
-extern char __StackLimit[];                          // start of code segment
-
-const uint32_t prog_space = TEXT_BYTES;
-const uint32_t data_space = DATA_BYTES;
+extern char __heap_start, __heap_end;                // heap bounds
 
 static union conv { //
     int i;          // integer value
@@ -147,7 +166,23 @@ struct patch_s {
     struct patch_s* locs; // list of patch locations for this address
     uint16_t* addr;       // patched address
     int val;              // patch value
-    int ext;              // is external function address
+    int ext;              // relocated at load, a segment or external function address
+};
+
+// case label of the switch statement being generated
+struct case_s {
+    int val;        // case value
+    uint16_t* addr; // code address
+};
+
+// switch statement of the function being generated, for the post pass and the listing
+struct switch_s {
+    struct switch_s* next; // list link
+    uint16_t* addr;        // dispatch code
+    uint16_t* tab;         // jump table, or NULL when dispatched by compares
+    int n;                 // jump table entries
+    int cases;             // case labels
+    int line;              // source line
 };
 
 // relocation list entry
@@ -156,6 +191,41 @@ struct reloc_s {
     int addr;             // address
 };
 
+// function definition, the body is generated once the whole program is parsed
+struct func_s {
+    struct func_s* next; // list link, in source order
+    struct ident_s* id;  // function identifier
+    int* ast;            // body AST
+    int nparms;          // parameter count
+    int line;            // line number of the end of the body
+    uint16_t* stub;      // prototype call stub address word, or NULL
+    int size;            // code bytes, once generated
+};
+
+// function referenced by a function body, or by a global initializer
+struct fref_s {
+    struct fref_s* next; // list link
+    struct func_s* from; // referencing function, NULL at global scope
+    struct ident_s* to;  // referenced function
+    int* data;           // initialized global, or NULL
+};
+
+// profile of a function
+struct prof_s {
+    char* name;     // function name
+    uint32_t calls; // call count
+    uint32_t total; // time in the function and its callees
+    uint32_t self;  // time in the function itself
+    int active;     // activations on the call stack
+};
+
+// profiled function activation
+struct prof_frame_s {
+    int f;        // function profile index
+    uint32_t t0;  // time at entry
+    uint32_t sub; // time spent in callees
+};
+
 // globals
 uint16_t* e; // current position in emitted code
 const uint16_t* text_base;
@@ -163,19 +233,39 @@ int exit_sp; // stack at entry to main
 
 static struct reloc_s* relocs UDATA;  // relocation list root
 static int nrelocs UDATA;             // relocation list size
+static struct func_s* funcs UDATA;    // function definition list root
+static struct func_s* func_end UDATA; // last function definition
+static struct func_s* func_cur UDATA; // function being parsed
+static struct fref_s* frefs UDATA;    // function reference list root
 static char *p UDATA, *lp UDATA;      // current position in source code
 static char* data UDATA;              // data/bss pointer
 static char* data_base UDATA;         // data/bss pointer
+static char* data_end UDATA;          // end of the data space, the bss grows down from bss_end
+static char* bss_end UDATA;           // end of the data segment space
+static uint16_t* text_end UDATA;      // end of the code segment space
+static void* text_seg UDATA;          // code segment heap block
+static void* data_seg UDATA;          // data segment heap block
+static int heap_reserve;              // heap reserved for the compiler's tables, 0 for the default
+static int heap_free UDATA;           // free heap when the segments were sized
+static int heap_short UDATA;          // the compile ran out of heap, retry it
+static int compiling UDATA;           // compiling, the segments are in use by the compiler
 static int* base_sp UDATA;            // stack
 static uint16_t* le UDATA;            //
-static uint16_t* ecas UDATA;          // case statement patch-up pointer
 static int* ncas UDATA;               // case statement patch-up pointer
 static uint16_t* def UDATA;           // default statement patch-up pointer
+static struct case_s* sw_case UDATA;  // case labels of the innermost switch, sorted by value
+static int sw_ncase UDATA;            // their count
+static struct switch_s* sws UDATA;    // switch statements of the current function
+static struct patch_s* sw_jmps UDATA; // dispatch jumps to the case labels of the innermost switch
 static struct patch_s* brks UDATA;    // break statement patch-up pointer
 static struct patch_s* cnts UDATA;    // continue statement patch-up pointer
 static struct patch_s* pcrel UDATA;   // pc relative address patch-up pointer
 static uint16_t* pcrel_1st UDATA;     // first relative load address in group
 static int pcrel_count UDATA;         // first relative load address in group
+static int pool_cnt UDATA;            // literal pools emitted
+static int pool_jmp UDATA;            // literal pools needing a branch around them
+static int pool_dup UDATA;            // literal loads sharing a pool entry
+static int pool_reuse UDATA;          // literal loads reaching back to an earlier function
 static int swtc UDATA;                // !0 -> in a switch-stmt context
 static int brkc UDATA;                // !0 -> in a break-stmt context
 static int cntc UDATA;                // !0 -> in a continue-stmt context
@@ -197,6 +287,12 @@ static int lineno UDATA;              // current line number
 static int src_opt UDATA;             // print source and assembly flag
 static int nopeep_opt UDATA;          // turn off peep-hole optimization
 static int uchar_opt UDATA;           // use unsigned character variables
+static int xip_opt UDATA;             // save the executable to run in place from flash
+static int zip_opt UDATA;             // compress the executable's code and data
+static int prof_opt UDATA;            // profile the functions of the program
+static int prof_fn UDATA;             // profile index of the function being generated
+static int fold_cnt UDATA;            // AST nodes removed by constant folding
+static int lbl_cnt UDATA;             // labels and case labels parsed so far
 static int* n UDATA;                  // current position in emitted abstract syntax tree
                                       // With an AST, the compiler is not limited to generate
                                       // code on the fly with parsing.
@@ -209,7 +305,25 @@ static int* ast UDATA;                // abstract syntax tree
 static ARMSTATE state UDATA;          // disassembler state
 static char* ofn UDATA;               // output file (executable) name
 static int indef UDATA;               // parsing in define statement
-static char* src_base UDATA;          // source code region
+static char* src_base UDATA;          // source window
+static char* src_end UDATA;           // end of the source in the window
+static int src_eof UDATA;             // source file read to the end
+static char *name_pool UDATA, *name_end UDATA; // identifier name pool
+static lfs_file_t* fd UDATA;          // source or executable file
+static int* rv_use UDATA;             // weighted use count per frame slot, -1 if address taken
+static int rv_bias UDATA;             // frame offset to rv_use index bias
+static int rv_ofs[REG_VARS] UDATA;    // frame offsets of the register variables
+static int rv_cnt UDATA;              // register variable count in current function
+static int rv_cmpd UDATA;             // register target of current compound assignment
+static int* var_cmpd UDATA;           // direct target of current compound assignment
+static int gb_reg UDATA;              // global base register of current function, 0 if none
+static int gb_base UDATA;             // address in the global base register
+static int gb_use[2] UDATA;           // weighted uses of the globals in reach of the bss, data
+static int rv_call UDATA;             // current function calls out
+static int fp_omit UDATA;             // current function has no frame pointer
+static int fp_leaf UDATA;             // current function makes no calls and keeps lr in ip
+static int fp_calls UDATA;            // calls emitted in the current function
+static int rs_depth UDATA;            // expression register stack depth
 
 // identifier
 struct ident_s {
@@ -227,11 +341,15 @@ struct ident_s {
     int etype, hetype;    // extended type info. different meaning for funcs.
     uint16_t* forward;    // forward call patch address
     uint8_t inserted : 1; // inserted in disassembler table
+    uint8_t live : 1;     // function reachable from main
 };
 
 // symbol table
 static struct ident_s *id UDATA, // currently parsed identifier
     *sym_base UDATA;             // symbol table (simple list of identifiers)
+static struct ident_s** sym_hash UDATA; // open addressed index of the symbol table
+static int sym_bits UDATA;              // log2 of the index size
+static int sym_cnt UDATA;               // identifiers in the index
 
 // struct member list entry
 struct member_s {
@@ -272,6 +390,7 @@ struct define_grp {
 #include "cc_defs.h"
 
 static jmp_buf done_jmp UDATA; // fatal error jump address
+static jmp_buf* size_jmp UDATA; // end of sizing a dead function when the code segment fills
 
 __attribute__((__noreturn__)) void fatal_func(const char* func, int lne, const char* fmt, ...) {
     printf("\n");
@@ -283,13 +402,17 @@ __attribute__((__noreturn__)) void fatal_func(const char* func, int lne, const c
     va_start(ap, fmt);
     vprintf(fmt, ap);
     va_end(ap);
-    if (lineno > 0) {
-        lp = src_base;
-        int lno = lineno;
-        while (--lno)
-            lp = strchr(lp, '\n') + 1;
-        p = strchr(lp, '\n');
-        printf("\n" VT_BOLD "%d:" VT_NORMAL " %.*s\n", lineno, p - lp, lp);
+    if (lineno > 0 && src_base) { // re-read the line from the source file
+        printf("\n" VT_BOLD "%d:" VT_NORMAL " ", lineno);
+        fs_file_seek(fd, 0, SEEK_SET);
+        int lno = 1, l;
+        while (lno <= lineno && (l = fs_file_read(fd, src_base, SRC_BYTES)) > 0)
+            for (char* c = src_base; c < src_base + l && lno <= lineno; c++)
+                if (*c == '\n')
+                    ++lno;
+                else if (lno == lineno)
+                    putchar(*c);
+        printf("\n");
     }
     longjmp(done_jmp, 1); // bail out
 }
@@ -458,7 +581,6 @@ static const struct {
                 {"clocks", clk_defines},  {"i2c", i2c_defines},       {"spi", spi_defines},
                 {"irq", irq_defines},     {"uart", uart_defines},     {0}};
 
-static lfs_file_t* fd UDATA;
 static char* fp UDATA;
 
 #define NUMOF(a) (sizeof(a) / sizeof(a[0]))
@@ -494,7 +616,7 @@ typedef struct {
     int tk;
     int v1;
 } Double_entry_t;
-#define Double_entry(a) (*((Double_entry_t*)a))
+#define Double_entry(a) (*((Double_entry_t*)(a)))
 #define Double_words (sizeof(Double_entry_t) / sizeof(int))
 
 typedef struct {
@@ -504,7 +626,7 @@ typedef struct {
     int n_parms;
     int parm_types;
 } Func_entry_t;
-#define Func_entry(a) (*((Func_entry_t*)a))
+#define Func_entry(a) (*((Func_entry_t*)(a)))
 #define Func_words (sizeof(Func_entry_t) / sizeof(int))
 
 static void ast_Func(int parm_types, int n_parms, int addr, int next, int tk) {
@@ -523,7 +645,7 @@ typedef struct {
     int body;
     int init;
 } For_entry_t;
-#define For_entry(a) (*((For_entry_t*)a))
+#define For_entry(a) (*((For_entry_t*)(a)))
 #define For_words (sizeof(For_entry_t) / sizeof(int))
 
 static void ast_For(int init, int body, int incr, int cond) {
@@ -541,7 +663,7 @@ typedef struct {
     int if_part;
     int else_part;
 } Cond_entry_t;
-#define Cond_entry(a) (*((Cond_entry_t*)a))
+#define Cond_entry(a) (*((Cond_entry_t*)(a)))
 #define Cond_words (sizeof(Cond_entry_t) / sizeof(int))
 
 static void ast_Cond(int else_part, int if_part, int cond_part) {
@@ -557,7 +679,7 @@ typedef struct {
     int type;
     int right_part;
 } Assign_entry_t;
-#define Assign_entry(a) (*((Assign_entry_t*)a))
+#define Assign_entry(a) (*((Assign_entry_t*)(a)))
 #define Assign_words (sizeof(Assign_entry_t) / sizeof(int))
 
 static void ast_Assign(int right_part, int type) {
@@ -572,7 +694,7 @@ typedef struct {
     int body;
     int cond;
 } While_entry_t;
-#define While_entry(a) (*((While_entry_t*)a))
+#define While_entry(a) (*((While_entry_t*)(a)))
 #define While_words (sizeof(While_entry_t) / sizeof(int))
 
 static void ast_While(int cond, int body, int tk) {
@@ -586,12 +708,14 @@ typedef struct {
     int tk;
     int cond;
     int cas;
+    int line;
 } Switch_entry_t;
-#define Switch_entry(a) (*((Switch_entry_t*)a))
+#define Switch_entry(a) (*((Switch_entry_t*)(a)))
 #define Switch_words (sizeof(Switch_entry_t) / sizeof(int))
 
-static void ast_Switch(int cas, int cond) {
+static void ast_Switch(int cas, int cond, int line) {
     push_ast(Switch_words);
+    Switch_entry(n).line = line;
     Switch_entry(n).cas = cas;
     Switch_entry(n).cond = cond;
     Switch_entry(n).tk = Switch;
@@ -602,10 +726,11 @@ typedef struct {
     int next;
     int expr;
 } Case_entry_t;
-#define Case_entry(a) (*((Case_entry_t*)a))
+#define Case_entry(a) (*((Case_entry_t*)(a)))
 #define Case_words (sizeof(Case_entry_t) / sizeof(int))
 
 static void ast_Case(int expr, int next) {
+    ++lbl_cnt;
     push_ast(Case_words);
     Case_entry(n).expr = expr;
     Case_entry(n).next = next;
@@ -617,7 +742,7 @@ typedef struct {
     int val;
     int way;
 } CastF_entry_t;
-#define CastF_entry(a) (*((CastF_entry_t*)a))
+#define CastF_entry(a) (*((CastF_entry_t*)(a)))
 #define CastF_words (sizeof(CastF_entry_t) / sizeof(int))
 
 static void ast_CastF(int way, int val) {
@@ -631,7 +756,7 @@ typedef struct {
     int tk;
     int val;
 } Enter_entry_t;
-#define Enter_entry(a) (*((Enter_entry_t*)a))
+#define Enter_entry(a) (*((Enter_entry_t*)(a)))
 #define Enter_words (sizeof(Enter_entry_t) / sizeof(int))
 
 static uint16_t* ast_Enter(int val) {
@@ -651,10 +776,14 @@ typedef struct {
     int tk;
     int oprnd;
 } Oper_entry_t;
-#define Oper_entry(a) (*((Oper_entry_t*)a))
+#define Oper_entry(a) (*((Oper_entry_t*)(a)))
 #define Oper_words (sizeof(Oper_entry_t) / sizeof(int))
 
+static int fold_oper(int* b, int op);
+
 static void ast_Oper(int oprnd, int op) {
+    if (fold_oper((int*)oprnd, op))
+        return;
     push_ast(Oper_words);
     Oper_entry(n).tk = op;
     Oper_entry(n).oprnd = oprnd;
@@ -663,19 +792,26 @@ static void ast_Oper(int oprnd, int op) {
 typedef struct {
     int tk;
     int val;
-    int valH;
+    int seg; // derived from a global, string or function address
 } Num_entry_t;
-#define Num_entry(a) (*((Num_entry_t*)a))
+#define Num_entry(a) (*((Num_entry_t*)(a)))
 #define Num_words (sizeof(Num_entry_t) / sizeof(int))
 
 static void ast_Num(int val) {
     push_ast(Num_words);
     Num_entry(n).tk = Num;
     Num_entry(n).val = val;
-    Num_entry(n).valH = 0;
+    Num_entry(n).seg = 0;
+}
+
+// address of a global or a string, relocated when loaded from the literal pool
+static void ast_Addr(int val) {
+    ast_Num(val);
+    Num_entry(n).seg = 1;
 }
 
 static void ast_Label(int v1) {
+    ++lbl_cnt;
     push_ast(Double_words);
     Double_entry(n).tk = Label;
     Double_entry(n).v1 = v1;
@@ -688,6 +824,7 @@ static void ast_Goto(int v1) {
 }
 
 static void ast_Default(int v1) {
+    ++lbl_cnt;
     push_ast(Double_words);
     Double_entry(n).tk = Default;
     Double_entry(n).v1 = v1;
@@ -697,7 +834,7 @@ static void ast_NumF(int v1) {
     push_ast(Num_words);
     Num_entry(n).tk = NumF;
     Num_entry(n).val = v1;
-    Num_entry(n).valH = 0;
+    Num_entry(n).seg = 0;
 }
 
 static void ast_Loc(int addr) {
@@ -706,11 +843,25 @@ static void ast_Loc(int addr) {
     Double_entry(n).v1 = addr;
 }
 
+// reference to the expression at a
+static void ast_Paren(int* a) {
+    push_ast(Double_words);
+    Double_entry(n).tk = '(';
+    Double_entry(n).v1 = (int)a;
+}
+
+// address of function d, known once its code is generated
+static void ast_Id(struct ident_s* d) {
+    push_ast(Double_words);
+    Double_entry(n).tk = Id;
+    Double_entry(n).v1 = (int)d;
+}
+
 typedef struct {
     int tk;
     int typ;
 } Load_entry_t;
-#define Load_entry(a) (*((Load_entry_t*)a))
+#define Load_entry(a) (*((Load_entry_t*)(a)))
 #define Load_words (sizeof(Load_entry_t) / sizeof(int))
 
 static void ast_Load(int typ) {
@@ -723,7 +874,7 @@ typedef struct {
     int tk;
     int* next;
 } Begin_entry_t;
-#define Begin_entry(a) (*((Begin_entry_t*)a))
+#define Begin_entry(a) (*((Begin_entry_t*)(a)))
 #define Begin_words (sizeof(Begin_entry_t) / sizeof(int))
 
 static void ast_Begin(int* next) {
@@ -737,7 +888,7 @@ static void ast_Begin(int* next) {
 typedef struct {
     int tk;
 } Single_entry_t;
-#define Single_entry(a) (*((Single_entry_t*)a))
+#define Single_entry(a) (*((Single_entry_t*)(a)))
 #define Single_words (sizeof(Single_entry_t) / sizeof(int))
 
 #define ast_Tk(a) (Single_entry(a).tk)
@@ -750,7 +901,7 @@ static void ast_Single(int k) {
 typedef struct {
     int tk;
 } End_entry_t;
-#define End_entry(a) (*((End_entry_t*)a))
+#define End_entry(a) (*((End_entry_t*)(a)))
 #define End_words (sizeof(End_entry_t) / sizeof(int))
 
 static void ast_End(void) {
@@ -758,145 +909,918 @@ static void ast_End(void) {
     End_entry(n).tk = ';';
 }
 
-static void expr(int lev);
+// constant folding and algebraic simplification
 
-/* parse next token
- * 1. store data into id and then set the id to current lexcial form
- * 2. set tk to appropriate type
- */
-static void next() {
-    char *pp, *tp, tc;
-    int t, t2;
-    struct ident_s* i2;
+// AST at a can be evaluated and discarded without side effects
+static int ast_pure(int* a) {
+    switch (ast_Tk(a)) {
+    case Num:
+    case NumF:
+    case Loc:
+    case Id:
+        return 1;
+    case Load:
+        return ast_pure(a + Load_words);
+    case CastF:
+        return ast_pure((int*)CastF_entry(a).val);
+    case '(':
+        return ast_pure((int*)Double_entry(a).v1);
+    default:
+        if (ast_Tk(a) >= Lor && ast_Tk(a) <= LeF)
+            return ast_pure((int*)Oper_entry(a).oprnd) && ast_pure(a + Oper_words);
+        return 0;
+    }
+}
 
-    /* using loop to ignore whitespace characters, but characters that
-     * cannot be recognized by the lexical analyzer are considered blank
-     * characters, such as '@' and '$'.
-     */
-    while ((tk = *p)) {
-        ++p;
-        if ((tk >= 'a' && tk <= 'z') || (tk >= 'A' && tk <= 'Z') || (tk == '_')) {
-            pp = p - 1;
-            while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
-                   (*p >= '0' && *p <= '9') || (*p == '_'))
-                tk = tk * 147 + *p++;
-            tk = (tk << 6) + (p - pp); // hash plus symbol length
-            // hash value is used for fast comparison. Since it is inaccurate,
-            // we have to validate the memory content as well.
-            id = sym_base;
-            for (id = sym_base; id; id = id->next) { // find one free slot in table
-                if (tk == id->hash &&                // if token is found (hash match), overwrite
-                    !memcmp(id->name, pp, p - pp)) {
-                    tk = id->tk;
-                    return;
-                }
-            }
-            /* At this point, existing symbol name is not found.
-             * "id" points to the first unused symbol table entry.
-             */
-            id = cc_malloc(sizeof(struct ident_s), 1, 1);
-            id->name = pp;
-            id->hash = tk;
-            id->forward = 0;
-            id->inserted = 0;
-            tk = id->tk = Id; // token type identifier
-            id->next = sym_base;
-            sym_base = id;
-            return;
+// integer constant operation, 0 if left to run time
+static int fold_int(int op, int l, int r, int* v) {
+    switch (op) {
+    case Or:
+        *v = l | r;
+        break;
+    case Xor:
+        *v = l ^ r;
+        break;
+    case And:
+        *v = l & r;
+        break;
+    case Eq:
+        *v = l == r;
+        break;
+    case Ne:
+        *v = l != r;
+        break;
+    case Ge:
+        *v = l >= r;
+        break;
+    case Lt:
+        *v = l < r;
+        break;
+    case Gt:
+        *v = l > r;
+        break;
+    case Le:
+        *v = l <= r;
+        break;
+    case Shl:
+        if (r < 0 || r > 31)
+            return 0;
+        *v = l << r;
+        break;
+    case Shr:
+        if (r < 0 || r > 31)
+            return 0;
+        *v = l >> r;
+        break;
+    case Add:
+        *v = l + r;
+        break;
+    case Sub:
+        *v = l - r;
+        break;
+    case Mul:
+        *v = l * r;
+        break;
+    case Div:
+        if (r == 0 || r == -1)
+            return 0;
+        *v = l / r;
+        break;
+    case Mod:
+        if (r == 0 || r == -1)
+            return 0;
+        *v = l % r;
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+// float constant operation, 0 if left to run time
+static int fold_float(int op, int* b, int* r) {
+    float x = *((float*)&Num_entry(b).val), y = *((float*)&Num_entry(r).val);
+    int v = -1;
+    switch (op) {
+    case AddF:
+        x += y;
+        break;
+    case SubF:
+        x -= y;
+        break;
+    case MulF:
+        x *= y;
+        break;
+    case DivF:
+        x /= y;
+        break;
+    case EqF:
+        v = x == y;
+        break;
+    case NeF:
+        v = x != y;
+        break;
+    case GeF:
+        v = x >= y;
+        break;
+    case LtF:
+        v = x < y;
+        break;
+    case GtF:
+        v = x > y;
+        break;
+    case LeF:
+        v = x <= y;
+        break;
+    default:
+        return 0;
+    }
+    if (v < 0)
+        *((float*)&Num_entry(b).val) = x;
+    else {
+        ast_Tk(b) = Num;
+        Num_entry(b).val = v;
+    }
+    return 1;
+}
+
+// Simplify the binary operator op about to be built over the left operand at b and the right
+// operand at the top of the AST. Returns 1 if the result was left at the top instead.
+static int fold_oper(int* b, int op) {
+    int *r = n, v;
+    if (op < Lor || op > LeF)
+        return 0;
+    if (ast_Tk(b) == Load && ast_Tk(b + Load_words) == ';')
+        return 0; // compound assignment expects its address in r0
+    if (op == Lor || op == Lan) {
+        if (ast_Tk(b) != Num || !Num_entry(b).val != (op == Lan))
+            return 0; // right operand is evaluated
+        Num_entry(b).val = (op == Lor);
+        n = b;
+    } else if (ast_Tk(b) == NumF && ast_Tk(r) == NumF) {
+        if (!fold_float(op, b, r))
+            return 0;
+        n = b;
+    } else if (ast_Tk(b) == Num && ast_Tk(r) == Num) {
+        if (!fold_int(op, Num_entry(b).val, Num_entry(r).val, &v))
+            return 0;
+        Num_entry(b).val = v;
+        Num_entry(b).seg |= Num_entry(r).seg;
+        n = b;
+    } else if (ast_Tk(r) == Num) {
+        v = Num_entry(r).val;
+        if ((v == 0 && (op == Or || op == Xor || op == Shl || op == Shr || op == Add ||
+                        op == Sub)) ||
+            (v == 1 && (op == Mul || op == Div)) || (v == -1 && op == And))
+            n = b; // x op identity
+        else if (v == 0 && (op == And || op == Mul) && ast_pure(b))
+            ; // x & 0, x * 0
+        else if ((op == Add || op == Sub) && (ast_Tk(b) == Add || ast_Tk(b) == Sub) &&
+                 ast_Tk(b + Oper_words) == Num) {
+            // (x +- c1) +- c2
+            Num_entry(b + Oper_words).val += (op == ast_Tk(b)) ? v : -v;
+            n = b;
+        } else
+            return 0;
+    } else if (ast_Tk(r) == NumF) {
+        if (Num_entry(r).val != 0x3f800000 || (op != MulF && op != DivF))
+            return 0;
+        n = b; // x * 1.0, x / 1.0
+    } else if (ast_Tk(b) == Num) {
+        v = Num_entry(b).val;
+        if ((v == 0 && (op == Or || op == Xor || op == Add)) || (v == 1 && op == Mul) ||
+            (v == -1 && op == And))
+            ; // identity op x
+        else if (v == 0 && (op == And || op == Mul || op == Shl || op == Shr) && ast_pure(r))
+            n = b; // 0 op x
+        else
+            return 0;
+    } else
+        return 0;
+    ++fold_cnt;
+    return 1;
+}
+
+// Loop strength reduction. In a for loop whose counter only changes in the increment expression,
+// by a loop invariant step, an address computed as loop invariant terms plus a multiple of the
+// counter is kept in a new pointer variable. The pointer is set after the loop initialization
+// and stepped along with the counter. Addresses that differ by a constant share a pointer.
+// Pointers are only added while they and the function's variables all fit in registers.
+
+#define LSR_VARS 8                    // pointers added per function
+#define LSR_LOOP ((REG_VARS + 1) / 2) // pointers added per loop
+#define LSR_TERMS 4                   // loop invariant terms of an address
+#define LSR_MOD 1                     // frame slot changes in the loop
+#define LSR_ADR 2                     // frame slot address is taken, or it is not a word
+#define LSR_USE 4                     // frame slot is used
+
+struct lsr_s {
+    int k;             // counter multiplier
+    int c;             // constant term
+    int nt;            // number of loop invariant terms
+    int m[LSR_TERMS];  // term multipliers
+    int* t[LSR_TERMS]; // loop invariant terms
+    int ofs;           // frame offset of the pointer
+    int* init;         // initial address
+};
+
+static int* lsr_slot UDATA;                  // LSR_ flags per frame slot
+static int lsr_bias UDATA;                   // frame offset to lsr_slot index bias
+static int lsr_mem UDATA;                    // loop stores to memory or calls
+static int lsr_lbl UDATA;                    // loop contains a label
+static int lsr_iv UDATA;                     // frame offset of the loop counter
+static int lsr_vars UDATA;                   // pointers added to the current function
+static int lsr_room UDATA;                   // registers left for pointers
+static int lsr_cnt UDATA;                    // pointers added to the current loop
+static struct lsr_s lsr_grp[LSR_LOOP] UDATA; // the current loop's pointers
+
+static int rv_word(int t);
+
+static void lsr_use(int* a, int w) {
+    lsr_slot[Num_entry(a).val + lsr_bias] |= w ? LSR_USE : LSR_ADR;
+}
+
+// record the variables the AST at a uses, changes or takes the address of
+static void lsr_scan(int* a) {
+    int* b;
+    if (a == 0)
+        return;
+    switch (ast_Tk(a)) {
+    case Loc:
+        lsr_slot[Num_entry(a).val + lsr_bias] |= LSR_ADR;
+        break;
+    case Load:
+        if (ast_Tk(a + Load_words) == Loc)
+            lsr_use(a + Load_words, rv_word(Load_entry(a).typ));
+        else
+            lsr_scan(a + Load_words);
+        break;
+    case Assign:
+        b = (int*)Assign_entry(a).right_part;
+        if (ast_Tk(b) == Loc) {
+            lsr_slot[Num_entry(b).val + lsr_bias] |= LSR_MOD;
+            lsr_use(b, rv_word(Assign_entry(a).type & 0xffff));
+        } else {
+            lsr_mem = 1;
+            lsr_scan(b);
         }
-        /* Calculate the constant */
-        // first byte is a number, and it is considered a numerical value
-        else if (tk >= '0' && tk <= '9') {
-            tk = Num;                             // token is char or int
-            tkv.i = strtoul((pp = p - 1), &p, 0); // octal, decimal, hex parsing
-            if (*p == '.') {
-                tkv.f = strtof(pp, &p);
-                tk = NumF;
-            } // float
-            return;
+        lsr_scan(a + Assign_words);
+        break;
+    case Inc:
+    case Dec:
+        if (ast_Tk(a + Oper_words) == Loc) {
+            lsr_slot[Num_entry(a + Oper_words).val + lsr_bias] |= LSR_MOD;
+            lsr_use(a + Oper_words, Num_entry(a).val != CHAR);
+        } else {
+            lsr_mem = 1;
+            lsr_scan(a + Oper_words);
         }
-        switch (tk) {
-        case '\n':
-            if (src_opt) {
-                printf("%d: %.*s", lineno, p - lp, lp);
-                lp = p;
-            }
-            ++lineno;
-            if (indef) {
-                indef = 0;
-                tk = ';';
-                return;
-            }
-        case ' ':
-        case '\t':
-        case '\v':
-        case '\f':
-        case '\r':
-            break;
-        case '/':
-            if (*p == '/') { // comment
-                while (*p != 0 && *p != '\n')
-                    ++p;
-            } else if (*p == '*') { // C-style multiline comments
-                for (++p; (*p != 0); ++p) {
-                    pp = p + 1;
-                    if (*p == '\n') {
-                        ++lineno;
-                    } else if (*p == '*' && *pp == '/') {
-                        p += 1;
-                        break;
-                    }
-                }
-                if (*p)
-                    ++p;
-            } else {
-                if (*p == '=') {
-                    ++p;
-                    tk = DivAssign;
-                } else
-                    tk = Div;
-                return;
-            }
-            break;
-        case '#': // skip include statements, and most preprocessor directives
-            if (!strncmp(p, "define", 6)) {
-                p += 6;
-                next();
-                i2 = id;
-                // anything before eol?
-                tp = p;
-                while ((*tp == ' ') || (*tp == '\t'))
-                    ++tp;
-                if ((*tp != 0) && (*tp != '\n') && memcmp(tp, "//", 2) && memcmp(tp, "/*", 2)) {
-                    // id->class = Glo;
-                    indef = 1; // prevent recursive loop
-                    next();
-                    expr(Assign);
-                    if ((ast_Tk(n) == Num) || (ast_Tk(n) == NumF)) {
-                        id = i2;
-                        id->class = ast_Tk(n);
-                        id->type = ast_Tk(n) == Num ? INT : FLOAT;
-                        id->val = Num_entry(n).val;
-                        n += Num_words;
-                        break;
-                    } else
-                        fatal("define value must be a constant integer or float expression");
-                } else {
-                    id->class = Num;
-                    id->type = INT;
-                    id->val = 0;
-                }
-            } else if ((t = !strncmp(p, "ifdef", 5)) || !strncmp(p, "ifndef", 6)) {
-                p += 6;
-                next();
-                if (tk != Id)
-                    fatal("No identifier");
-                ++pplev;
-                if ((((id->class != Num && id->class != NumF) ? 0 : 1) ^ (t ? 1 : 0)) & 1) {
-                    t = pplevt;
-                    pplevt = pplev - 1;
-                    while (*p != 0 && *p != '\n')
-                        ++p; // discard until end-of-line
+        break;
+    case '{':
+        lsr_scan(Begin_entry(a).next);
+        lsr_scan(a + Begin_words);
+        break;
+    case '(':
+        lsr_scan((int*)Double_entry(a).v1);
+        break;
+    case Cond:
+        lsr_scan((int*)Cond_entry(a).cond_part);
+        lsr_scan((int*)Cond_entry(a).if_part);
+        lsr_scan((int*)Cond_entry(a).else_part);
+        break;
+    case CastF:
+        lsr_scan((int*)CastF_entry(a).val);
+        break;
+    case Func:
+    case Syscall:
+        lsr_mem = 1;
+        for (b = (int*)Func_entry(a).next; b; b = (int*)ast_Tk(b))
+            lsr_scan(b + Single_words);
+        break;
+    case While:
+    case DoWhile:
+        lsr_scan((int*)While_entry(a).cond);
+        lsr_scan((int*)While_entry(a).body);
+        break;
+    case For:
+        lsr_scan((int*)For_entry(a).init);
+        lsr_scan((int*)For_entry(a).cond);
+        lsr_scan((int*)For_entry(a).body);
+        lsr_scan((int*)For_entry(a).incr);
+        break;
+    case Switch:
+        lsr_scan((int*)Switch_entry(a).cond);
+        lsr_scan((int*)Switch_entry(a).cas);
+        break;
+    case Case:
+        lsr_scan((int*)Case_entry(a).next);
+        lsr_scan((int*)Case_entry(a).expr);
+        break;
+    case Label:
+        lsr_lbl = 1;
+        break;
+    case Default:
+    case Return:
+        lsr_scan((int*)Double_entry(a).v1);
+        break;
+    default:
+        if (ast_Tk(a) >= Lor && ast_Tk(a) <= LeF) {
+            lsr_scan((int*)Oper_entry(a).oprnd);
+            lsr_scan(a + Oper_words);
+        }
+    }
+}
+
+// AST at a is pure and has the same value on every loop iteration
+static int lsr_inv(int* a) {
+    int* b;
+    switch (ast_Tk(a)) {
+    case Num:
+    case NumF:
+    case Loc:
+        return 1;
+    case Load:
+        b = a + Load_words;
+        if (ast_Tk(b) == Loc)
+            return !(lsr_slot[Num_entry(b).val + lsr_bias] & LSR_MOD) &&
+                   (!(lsr_slot[Num_entry(b).val + lsr_bias] & LSR_ADR) || !lsr_mem);
+        return !lsr_mem && lsr_inv(b);
+    case '(':
+        return lsr_inv((int*)Double_entry(a).v1);
+    case CastF:
+        return lsr_inv((int*)CastF_entry(a).val);
+    default:
+        if (ast_Tk(a) >= Or && ast_Tk(a) <= LeF)
+            return lsr_inv((int*)Oper_entry(a).oprnd) && lsr_inv(a + Oper_words);
+        return 0;
+    }
+}
+
+// split the address at a, times m, into counter, constant and loop invariant terms
+static int lsr_terms(int* a, int m, struct lsr_s* g) {
+    int *l, *r;
+    struct lsr_s s = *g;
+    switch (ast_Tk(a)) {
+    case Num:
+        g->c += m * Num_entry(a).val;
+        return 1;
+    case Load:
+        if (ast_Tk(a + Load_words) == Loc && Num_entry(a + Load_words).val == lsr_iv) {
+            if (Load_entry(a).typ != INT)
+                return 0;
+            g->k += m;
+            return 1;
+        }
+        break;
+    case '(':
+        return lsr_terms((int*)Double_entry(a).v1, m, g);
+    case Add:
+    case Sub:
+        if (lsr_terms((int*)Oper_entry(a).oprnd, m, g) &&
+            lsr_terms(a + Oper_words, (ast_Tk(a) == Add) ? m : -m, g))
+            return 1;
+        break;
+    case Mul:
+    case Shl:
+        l = (int*)Oper_entry(a).oprnd;
+        r = a + Oper_words;
+        if (ast_Tk(r) == Num && ast_Tk(a) == Shl && Num_entry(r).val >= 0 &&
+            Num_entry(r).val < 32 && lsr_terms(l, m << Num_entry(r).val, g))
+            return 1;
+        if (ast_Tk(r) == Num && ast_Tk(a) == Mul && lsr_terms(l, m * Num_entry(r).val, g))
+            return 1;
+        if (ast_Tk(l) == Num && ast_Tk(a) == Mul && lsr_terms(r, m * Num_entry(l).val, g))
+            return 1;
+        break;
+    }
+    *g = s; // otherwise a single loop invariant term
+    if (!lsr_inv(a) || g->nt == LSR_TERMS)
+        return 0;
+    g->m[g->nt] = m;
+    g->t[g->nt++] = a;
+    return 1;
+}
+
+// loop invariant ASTs at a and b compute the same value
+static int lsr_equal(int* a, int* b) {
+    while (ast_Tk(a) == '(')
+        a = (int*)Double_entry(a).v1;
+    while (ast_Tk(b) == '(')
+        b = (int*)Double_entry(b).v1;
+    if (ast_Tk(a) != ast_Tk(b))
+        return 0;
+    switch (ast_Tk(a)) {
+    case Num:
+    case NumF:
+    case Loc:
+        return Num_entry(a).val == Num_entry(b).val;
+    case Load:
+        return Load_entry(a).typ == Load_entry(b).typ && lsr_equal(a + Load_words, b + Load_words);
+    case CastF:
+        return CastF_entry(a).way == CastF_entry(b).way &&
+               lsr_equal((int*)CastF_entry(a).val, (int*)CastF_entry(b).val);
+    default:
+        return lsr_equal((int*)Oper_entry(a).oprnd, (int*)Oper_entry(b).oprnd) &&
+               lsr_equal(a + Oper_words, b + Oper_words);
+    }
+}
+
+// copy the loop invariant AST at a to the top of the AST
+static int* lsr_copy(int* a) {
+    int* l;
+    switch (ast_Tk(a)) {
+    case Num:
+    case NumF:
+        push_ast(Num_words);
+        Num_entry(n) = Num_entry(a);
+        break;
+    case Loc:
+        ast_Loc(Num_entry(a).val);
+        break;
+    case Load:
+        lsr_copy(a + Load_words);
+        ast_Load(Load_entry(a).typ);
+        break;
+    case '(':
+        return lsr_copy((int*)Double_entry(a).v1);
+    case CastF:
+        l = lsr_copy((int*)CastF_entry(a).val);
+        ast_CastF(CastF_entry(a).way, (int)l);
+        break;
+    default:
+        l = lsr_copy((int*)Oper_entry(a).oprnd);
+        lsr_copy(a + Oper_words);
+        push_ast(Oper_words);
+        Oper_entry(n).tk = ast_Tk(a);
+        Oper_entry(n).oprnd = (int)l;
+    }
+    return n;
+}
+
+// keep the address at a in a pointer, 1 if it was replaced
+static int lsr_addr(int* a) {
+    struct lsr_s t, *g;
+    int i, j;
+    if (ast_Tk(a) != Add && ast_Tk(a) != Sub)
+        return 0;
+    memset(&t, 0, sizeof(t));
+    if (!lsr_terms(a, 1, &t) || t.k == 0)
+        return 0;
+    // look for a pointer whose address differs by a constant
+    for (g = lsr_grp; g < lsr_grp + lsr_cnt; g++) {
+        if (g->k != t.k || g->nt != t.nt)
+            continue;
+        for (i = 0; i < t.nt; i++) {
+            for (j = 0; j < g->nt; j++)
+                if (g->m[j] == t.m[i] && lsr_equal(g->t[j], t.t[i]))
+                    break;
+            if (j == g->nt)
+                break;
+        }
+        if (i == t.nt)
+            break;
+    }
+    if (g == lsr_grp + lsr_cnt) {
+        if (lsr_cnt == LSR_LOOP || lsr_vars == LSR_VARS || lsr_vars >= lsr_room)
+            return 0;
+        *g = t;
+        g->init = lsr_copy(a);
+        g->ofs = loc - ++ld;
+        ++lsr_cnt;
+        ++lsr_vars;
+    }
+    // replace the address by the pointer, plus the constant difference
+    ast_Loc(g->ofs);
+    ast_Load(INT);
+    if (t.c != g->c) {
+        int* l = n;
+        ast_Num(t.c - g->c);
+        push_ast(Oper_words);
+        Oper_entry(n).tk = Add;
+        Oper_entry(n).oprnd = (int)l;
+    }
+    Double_entry(a).v1 = (int)n;
+    ast_Tk(a) = '(';
+    return 1;
+}
+
+// reduce the addresses in the AST at a
+static void lsr_walk(int* a) {
+    int* b;
+    if (a == 0)
+        return;
+    switch (ast_Tk(a)) {
+    case Load:
+        if (!lsr_addr(a + Load_words))
+            lsr_walk(a + Load_words);
+        break;
+    case Assign:
+        b = (int*)Assign_entry(a).right_part;
+        if (!lsr_addr(b))
+            lsr_walk(b);
+        lsr_walk(a + Assign_words);
+        break;
+    case Inc:
+    case Dec:
+        if (!lsr_addr(a + Oper_words))
+            lsr_walk(a + Oper_words);
+        break;
+    case '{':
+        lsr_walk(Begin_entry(a).next);
+        lsr_walk(a + Begin_words);
+        break;
+    case Cond:
+        lsr_walk((int*)Cond_entry(a).cond_part);
+        lsr_walk((int*)Cond_entry(a).if_part);
+        lsr_walk((int*)Cond_entry(a).else_part);
+        break;
+    case CastF:
+        lsr_walk((int*)CastF_entry(a).val);
+        break;
+    case Func:
+    case Syscall:
+        for (b = (int*)Func_entry(a).next; b; b = (int*)ast_Tk(b))
+            lsr_walk(b + Single_words);
+        break;
+    case While:
+    case DoWhile:
+        lsr_walk((int*)While_entry(a).cond);
+        lsr_walk((int*)While_entry(a).body);
+        break;
+    case For:
+        lsr_walk((int*)For_entry(a).init);
+        lsr_walk((int*)For_entry(a).cond);
+        lsr_walk((int*)For_entry(a).body);
+        lsr_walk((int*)For_entry(a).incr);
+        break;
+    case Switch:
+        lsr_walk((int*)Switch_entry(a).cond);
+        lsr_walk((int*)Switch_entry(a).cas);
+        break;
+    case Case:
+        lsr_walk((int*)Case_entry(a).next);
+        lsr_walk((int*)Case_entry(a).expr);
+        break;
+    case Default:
+    case Return:
+        lsr_walk((int*)Double_entry(a).v1);
+        break;
+    default:
+        if (ast_Tk(a) >= Lor && ast_Tk(a) <= LeF) {
+            lsr_walk((int*)Oper_entry(a).oprnd);
+            lsr_walk(a + Oper_words);
+        }
+    }
+}
+
+// strength reduce the for loop at a
+static void lsr_loop(int* a) {
+    int *b = (int*)For_entry(a).incr, *step = 0, op = Add, i;
+    // the increment must be ++i, i++, --i, i--, i += step or i -= step
+    if ((ast_Tk(b) == Add || ast_Tk(b) == Sub) &&
+        (ast_Tk(Oper_entry(b).oprnd) == Inc || ast_Tk(Oper_entry(b).oprnd) == Dec))
+        b = (int*)Oper_entry(b).oprnd; // postfix
+    if ((ast_Tk(b) == Inc || ast_Tk(b) == Dec) && ast_Tk(b + Oper_words) == Loc &&
+        Num_entry(b).val == INT) {
+        op = (ast_Tk(b) == Inc) ? Add : Sub;
+        lsr_iv = Num_entry(b + Oper_words).val;
+    } else if (ast_Tk(b) == Assign && Assign_entry(b).type == ((INT << 16) | INT) &&
+               ast_Tk(Assign_entry(b).right_part) == Loc) {
+        lsr_iv = Num_entry(Assign_entry(b).right_part).val;
+        b += Assign_words;
+        if (ast_Tk(b) != Add && ast_Tk(b) != Sub)
+            return;
+        int* l = (int*)Oper_entry(b).oprnd;
+        if (ast_Tk(l) != Load ||
+            !(ast_Tk(l + Load_words) == ';' ||
+              (ast_Tk(l + Load_words) == Loc && Num_entry(l + Load_words).val == lsr_iv)))
+            return;
+        op = ast_Tk(b);
+        step = b + Oper_words;
+    } else
+        return;
+    if (lsr_slot[lsr_iv + lsr_bias] & LSR_ADR)
+        return;
+    // the counter may not change elsewhere and the loop must not be entered by a goto
+    for (i = 0; i < lsr_bias + loc + 1; i++) // slots of the locals and parameters
+        lsr_slot[i] &= ~LSR_MOD;
+    lsr_mem = lsr_lbl = 0;
+    lsr_scan((int*)For_entry(a).cond);
+    lsr_scan((int*)For_entry(a).body);
+    if (lsr_lbl || (lsr_slot[lsr_iv + lsr_bias] & LSR_MOD))
+        return;
+    lsr_scan((int*)For_entry(a).incr);
+    if (step && !lsr_inv(step))
+        return;
+    lsr_cnt = 0;
+    lsr_walk((int*)For_entry(a).cond);
+    lsr_walk((int*)For_entry(a).body);
+    // set the pointers after the initialization and step them after the increment
+    for (struct lsr_s* g = lsr_grp; g < lsr_grp + lsr_cnt; g++) {
+        ast_Loc(g->ofs);
+        b = n;
+        ast_Paren(g->init);
+        ast_Assign((int)b, (INT << 16) | INT);
+        ast_Begin((int*)For_entry(a).init);
+        For_entry(a).init = (int)n;
+        ast_Loc(g->ofs);
+        b = n;
+        ast_Loc(g->ofs);
+        ast_Load(INT);
+        int* l = n;
+        if (step) {
+            int* s = lsr_copy(step);
+            ast_Num(g->k);
+            ast_Oper((int)s, Mul);
+        } else
+            ast_Num(g->k);
+        ast_Oper((int)l, op);
+        ast_Assign((int)b, (INT << 16) | INT);
+        ast_Begin((int*)For_entry(a).incr);
+        For_entry(a).incr = (int)n;
+    }
+}
+
+// strength reduce the for loops in the statements at a
+static void lsr_stmt(int* a) {
+    if (a == 0)
+        return;
+    switch (ast_Tk(a)) {
+    case '{':
+        lsr_stmt(Begin_entry(a).next);
+        lsr_stmt(a + Begin_words);
+        break;
+    case Cond:
+        lsr_stmt((int*)Cond_entry(a).if_part);
+        lsr_stmt((int*)Cond_entry(a).else_part);
+        break;
+    case While:
+    case DoWhile:
+        lsr_stmt((int*)While_entry(a).body);
+        break;
+    case For:
+        lsr_loop(a);
+        lsr_stmt((int*)For_entry(a).body);
+        break;
+    case Switch:
+        lsr_stmt((int*)Switch_entry(a).cas);
+        break;
+    case Case:
+        lsr_stmt((int*)Case_entry(a).next);
+        lsr_stmt((int*)Case_entry(a).expr);
+        break;
+    case Default:
+        lsr_stmt((int*)Double_entry(a).v1);
+        break;
+    }
+}
+
+// strength reduce the loops of the function at a, adding its pointer variables
+static void lsr_func(int* a, int nparms) {
+    if (nopeep_opt)
+        return;
+    int nlocs = Enter_entry(a).val;
+    lsr_bias = nlocs + LSR_VARS;
+    lsr_slot = cc_malloc((lsr_bias + nparms + 2) * sizeof(int), 1, 1);
+    lsr_vars = 0;
+    lsr_scan(a + Enter_words); // address taken anywhere in the function
+    lsr_room = REG_VARS;
+    for (int i = 0; i < lsr_bias + nparms + 2; i++)
+        if ((lsr_slot[i] & (LSR_USE | LSR_ADR)) == LSR_USE)
+            --lsr_room;
+    lsr_stmt(a + Enter_words);
+    Enter_entry(a).val = ld - loc;
+    cc_free(lsr_slot, 0);
+    lsr_slot = NULL;
+}
+
+// symbol table index
+
+#define SYM_BITS 9 // initial index size, grows at half full
+
+// home slot of an identifier hash
+static int sym_slot(int h) { return ((unsigned)h * 0x9e3779b1u) >> (32 - sym_bits); }
+
+static void sym_insert(struct ident_s* d) {
+    int m = (1 << sym_bits) - 1, i;
+    for (i = sym_slot(d->hash); sym_hash[i]; i = (i + 1) & m)
+        ;
+    sym_hash[i] = d;
+}
+
+static void sym_grow(void) {
+    struct ident_s** old = sym_hash;
+    int sz = old ? 1 << sym_bits : 0;
+    sym_bits = old ? sym_bits + 1 : SYM_BITS;
+    sym_hash = cc_malloc(sizeof(struct ident_s*) << sym_bits, 1, 1);
+    for (int i = 0; i < sz; i++)
+        if (old[i])
+            sym_insert(old[i]);
+    if (old)
+        cc_free(old, 0);
+}
+
+// remove d from the index, closing the gap in its probe sequence
+static void sym_remove(struct ident_s* d) {
+    int m = (1 << sym_bits) - 1, i, j, k;
+    for (i = sym_slot(d->hash); sym_hash[i] != d; i = (i + 1) & m)
+        ;
+    sym_hash[i] = 0;
+    for (j = (i + 1) & m; sym_hash[j]; j = (j + 1) & m) {
+        k = sym_slot(sym_hash[j]->hash);
+        if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+            sym_hash[i] = sym_hash[j];
+            sym_hash[j] = 0;
+            i = j;
+        }
+    }
+    --sym_cnt;
+}
+
+// source reader
+
+/* Slide the source window to start at p and top it up from the source file, so that the
+ * lexer always sees the whole of the next line. Called at the start of each line.
+ */
+static void src_fill(void) {
+    if (!src_base || p < src_base || p > src_end)
+        return; // not lexing the source file
+    int l = src_end - p;
+    if (src_eof || memchr(p, '\n', l))
+        return;
+    memmove(src_base, p, l);
+    lp = p = src_base;
+    src_end = src_base + l;
+    l = SRC_BYTES - l;
+    int r = fs_file_read(fd, src_end, l);
+    if (r < 0)
+        fatal("error reading source");
+    src_eof = r < l;
+    src_end += r;
+    *src_end = 0;
+    if (!src_eof && !memchr(p, '\n', src_end - p))
+        fatal("source line too long");
+}
+
+// copy an identifier name out of the source window into the name pool
+static char* name_intern(char* s, int l) {
+    if (name_pool + l + 1 > name_end) {
+        int sz = (l + 1 > NAME_POOL_BYTES) ? l + 1 : NAME_POOL_BYTES;
+        name_pool = cc_malloc(sz, 1, 0);
+        name_end = name_pool + sz;
+    }
+    char* d = name_pool;
+    memcpy(d, s, l);
+    d[l] = 0;
+    name_pool += l + 1;
+    return d;
+}
+
+static void expr(int lev);
+
+/* parse next token
+ * 1. store data into id and then set the id to current lexcial form
+ * 2. set tk to appropriate type
+ */
+static void next() {
+    char *pp, *tp, tc;
+    int t, t2;
+    struct ident_s* i2;
+
+    /* using loop to ignore whitespace characters, but characters that
+     * cannot be recognized by the lexical analyzer are considered blank
+     * characters, such as '@' and '$'.
+     */
+    while ((tk = *p)) {
+        ++p;
+        if ((tk >= 'a' && tk <= 'z') || (tk >= 'A' && tk <= 'Z') || (tk == '_')) {
+            pp = p - 1;
+            while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+                   (*p >= '0' && *p <= '9') || (*p == '_'))
+                tk = tk * 147 + *p++;
+            tk = (tk << 6) + (p - pp); // hash plus symbol length
+            // hash value is used for fast comparison. Since it is inaccurate,
+            // we have to validate the memory content as well.
+            t = (1 << sym_bits) - 1;
+            for (t2 = sym_slot(tk); (id = sym_hash[t2]); t2 = (t2 + 1) & t) {
+                if (tk == id->hash && // if token is found (hash match), overwrite
+                    !memcmp(id->name, pp, p - pp)) {
+                    tk = id->tk;
+                    return;
+                }
+            }
+            /* At this point, existing symbol name is not found.
+             * "t2" is the free index slot for it.
+             */
+            id = cc_malloc(sizeof(struct ident_s), 1, 1);
+            id->name = (pp >= src_base && pp < src_end) ? name_intern(pp, p - pp) : pp;
+            id->hash = tk;
+            id->forward = 0;
+            id->inserted = 0;
+            id->live = 0;
+            tk = id->tk = Id; // token type identifier
+            id->next = sym_base;
+            sym_base = id;
+            sym_hash[t2] = id;
+            if (++sym_cnt * 2 > t)
+                sym_grow();
+            return;
+        }
+        /* Calculate the constant */
+        // first byte is a number, and it is considered a numerical value
+        else if (tk >= '0' && tk <= '9') {
+            tk = Num;                             // token is char or int
+            tkv.i = strtoul((pp = p - 1), &p, 0); // octal, decimal, hex parsing
+            if (*p == '.') {
+                tkv.f = strtof(pp, &p);
+                tk = NumF;
+            } // float
+            return;
+        }
+        switch (tk) {
+        case '\n':
+            if (src_opt) {
+                printf("%d: %.*s", lineno, p - lp, lp);
+                lp = p;
+            }
+            ++lineno;
+            src_fill();
+            if (indef) {
+                indef = 0;
+                tk = ';';
+                return;
+            }
+        case ' ':
+        case '\t':
+        case '\v':
+        case '\f':
+        case '\r':
+            break;
+        case '/':
+            if (*p == '/') { // comment
+                while (*p != 0 && *p != '\n')
+                    ++p;
+            } else if (*p == '*') { // C-style multiline comments
+                for (++p; *p != 0 && !(*p == '*' && p[1] == '/');) {
+                    if (*p++ == '\n') {
+                        if (src_opt) {
+                            printf("%d: %.*s", lineno, p - lp, lp);
+                            lp = p;
+                        }
+                        ++lineno;
+                        src_fill();
+                    }
+                }
+                if (*p)
+                    p += 2;
+            } else {
+                if (*p == '=') {
+                    ++p;
+                    tk = DivAssign;
+                } else
+                    tk = Div;
+                return;
+            }
+            break;
+        case '#': // skip include statements, and most preprocessor directives
+            if (!strncmp(p, "define", 6)) {
+                p += 6;
+                next();
+                i2 = id;
+                // anything before eol?
+                tp = p;
+                while ((*tp == ' ') || (*tp == '\t'))
+                    ++tp;
+                if ((*tp != 0) && (*tp != '\n') && memcmp(tp, "//", 2) && memcmp(tp, "/*", 2)) {
+                    // id->class = Glo;
+                    indef = 1; // prevent recursive loop
+                    next();
+                    expr(Assign);
+                    if ((ast_Tk(n) == Num) || (ast_Tk(n) == NumF)) {
+                        id = i2;
+                        id->class = ast_Tk(n);
+                        id->type = ast_Tk(n) == Num ? INT : FLOAT;
+                        id->val = Num_entry(n).val;
+                        n += Num_words;
+                        break;
+                    } else
+                        fatal("define value must be a constant integer or float expression");
+                } else {
+                    id->class = Num;
+                    id->type = INT;
+                    id->val = 0;
+                }
+            } else if ((t = !strncmp(p, "ifdef", 5)) || !strncmp(p, "ifndef", 6)) {
+                p += 6;
+                next();
+                if (tk != Id)
+                    fatal("No identifier");
+                ++pplev;
+                if ((((id->class != Num && id->class != NumF) ? 0 : 1) ^ (t ? 1 : 0)) & 1) {
+                    t = pplevt;
+                    pplevt = pplev - 1;
+                    while (*p != 0 && *p != '\n')
+                        ++p; // discard until end-of-line
                     do
                         next();
                     while (pplev != pplevt);
@@ -984,7 +1908,7 @@ static void next() {
                 // if it is double quotes (string literal), it is considered as
                 // a string, copying characters to data
                 if (tk == '"') {
-                    if (data >= data_base + DATA_BYTES)
+                    if (data >= data_end)
                         fatal("program data exceeds data segment");
                     *data++ = tkv.i;
                 }
@@ -1161,6 +2085,43 @@ static void bitopcheck(int tl, int tr) {
 
 static bool is_power_of_2(int n) { return ((n - 1) & n) == 0; }
 
+// record a reference to function d from the function being parsed or a global initializer
+static void fn_ref(struct ident_s* d, int* data) {
+    struct fref_s* r;
+    if (!data) // functions reference each other once
+        for (r = frefs; r && r->from == func_cur; r = r->next)
+            if (r->to == d && !r->data)
+                return;
+    r = cc_malloc(sizeof(struct fref_s), 1, 1);
+    r->from = func_cur;
+    r->to = d;
+    r->data = data;
+    r->next = frefs;
+    frefs = r;
+}
+
+// record the word at addr for relocation by the loader
+static void reloc_add(int addr) {
+    struct reloc_s* r = cc_malloc(sizeof(struct reloc_s), 1, 1);
+    r->addr = addr;
+    r->next = relocs;
+    relocs = r;
+    nrelocs++;
+}
+
+// 1 if v addresses the code or data emitted so far, moved when the executable is loaded elsewhere
+static int seg_addr(int v) {
+    return (v >= (int)text_base && v <= (int)e) || (v >= (int)data_base && v <= (int)data) ||
+           (v >= (int)data_end && v <= (int)bss_end);
+}
+
+// function address initializing the global at data, stored once the function is generated
+static void fn_init(int* data) {
+    fn_ref((struct ident_s*)Double_entry(n).v1, data);
+    n += Double_words;
+    ast_Num(0);
+}
+
 static void check_pc_relative(void);
 
 /* expression parsing
@@ -1281,8 +2242,12 @@ static void expr(int lev) {
                     fatal("argument type mismatch");
             }
             next();
-            // function or system call id
-            ast_Func(tt, t, d->val, (int)b, d->class);
+            // function identifier or system call id
+            if (d->class == Func) {
+                fn_ref(d, NULL);
+                ast_Func(tt, t, (int)d, (int)b, Func);
+            } else
+                ast_Func(tt, t, d->val, (int)b, d->class);
             ty = d->type;
         }
         // enumeration, only enums have ->class == Num
@@ -1293,7 +2258,8 @@ static void expr(int lev) {
             ast_Num(d->val);
             ty = FLOAT;
         } else if (d->class == Func) {
-            ast_Num(d->val | 1);
+            fn_ref(d, NULL);
+            ast_Id(d);
             ty = INT;
         } else {
             // Variable get offset
@@ -1303,7 +2269,7 @@ static void expr(int lev) {
                 ast_Loc(loc - d->val);
                 break;
             case Glo:
-                ast_Num(d->val);
+                ast_Addr(d->val);
                 break;
             default:
                 fatal("undefined variable %.*s", d->hash & ADJ_MASK, d->name);
@@ -1328,15 +2294,15 @@ static void expr(int lev) {
         ty = FLOAT;
         break;
     case '"': // string, as a literal in data segment
-        ast_Num(tkv.i);
+        ast_Addr(tkv.i);
         next();
         // continuous `"` handles C-style multiline text such as `"abc" "def"`
         while (tk == '"') {
-            if (data >= data_base + DATA_BYTES)
+            if (data >= data_end)
                 fatal("program data exceeds data segment");
             next();
         }
-        if (data >= data_base + DATA_BYTES)
+        if (data >= data_end)
             fatal("program data exceeds data segment");
         data = (char*)(((int)data + sizeof(int)) & (-sizeof(int)));
         ty = CHAR + PTR;
@@ -1623,7 +2589,12 @@ static void expr(int lev) {
             expr(Cond);
             if (tc != ty)
                 fatal("both results need same type");
-            ast_Cond((int)n, (int)c, (int)b);
+            if (ast_Tk(b) == Num) { // constant condition selects one result
+                if (Num_entry(b).val)
+                    n = c;
+                ++fold_cnt;
+            } else
+                ast_Cond((int)n, (int)c, (int)b);
             break;
         case Lor: // short circuit, the logical or
             next();
@@ -1878,6 +2849,7 @@ static void expr(int lev) {
                 }
                 if (ast_Tk(n) == Num && ast_Tk(b) == Num) {
                     Num_entry(b).val += Num_entry(n).val;
+                    Num_entry(b).seg |= Num_entry(n).seg;
                     n = b;
                 } else if (sz != 1) {
                     ast_Num(sz);
@@ -2017,14 +2989,8 @@ static void expr(int lev) {
                 if (ast_Tk(n) == Num && ast_Tk(b) == Num) {
                     Num_entry(b).val /= Num_entry(n).val;
                     n = b;
-                } else {
-                    if (ast_Tk(n) == Num && Num_entry(n).val > 0 &&
-                        is_power_of_2(Num_entry(n).val)) {
-                        Num_entry(n).val = __builtin_popcount(Num_entry(n).val - 1);
-                        ast_Oper((int)b, Shr); // 2^n
-                    } else
-                        ast_Oper((int)b, Div);
-                }
+                } else
+                    ast_Oper((int)b, Div); // constant divisors are left to emit_div_const
                 ty = INT;
             }
             break;
@@ -2041,13 +3007,8 @@ static void expr(int lev) {
             if (ast_Tk(n) == Num && ast_Tk(b) == Num) {
                 Num_entry(b).val %= Num_entry(n).val;
                 n = b;
-            } else {
-                if (ast_Tk(n) == Num && Num_entry(n).val > 0 && is_power_of_2(Num_entry(n).val)) {
-                    --Num_entry(n).val;
-                    ast_Oper((int)b, And); // 2^n
-                } else
-                    ast_Oper((int)b, Mod);
-            }
+            } else
+                ast_Oper((int)b, Mod);
             ty = INT;
             break;
         case Dot:
@@ -2152,6 +3113,7 @@ static void expr(int lev) {
             }
             if (ast_Tk(n) == Num && ast_Tk(b) == Num) {
                 Num_entry(b).val += Num_entry(n).val;
+                Num_entry(b).seg |= Num_entry(n).seg;
                 n = b;
             } else
                 ast_Oper((int)b, Add);
@@ -2218,11 +3180,15 @@ static void init_array(struct ident_s* tn, int extent[], int dim) {
                 break;
         } else {
             expr(Cond);
+            if (ast_Tk(n) == Id && match == INT)
+                fn_init(vi + i);
             if (ast_Tk(n) != Num && ast_Tk(n) != NumF)
                 fatal("non-literal initializer");
 
             if (ty == CHAR + PTR) {
                 if (match == CHAR + PTR2) {
+                    if (ofn)
+                        reloc_add((int)(vi + i));
                     vi[i++] = Num_entry(n).val;
                 } else if (match == CHAR + PTR) {
                     off = strlen((char*)Num_entry(n).val) + 1;
@@ -2235,8 +3201,11 @@ static void init_array(struct ident_s* tn, int extent[], int dim) {
                     i += inc[0];
                 } else
                     fatal("can't assign string to scalar");
-            } else if (ty == match)
+            } else if (ty == match) {
+                if (ofn && ast_Tk(n) == Num && Num_entry(n).seg && seg_addr(Num_entry(n).val))
+                    reloc_add((int)(vi + i));
                 vi[i++] = Num_entry(n).val;
+            }
             else if (ty == INT) {
                 if (match == CHAR + PTR) {
                     *((char*)vi + i) = Num_entry(n).val;
@@ -2261,9 +3230,30 @@ static void init_array(struct ident_s* tn, int extent[], int dim) {
 
 // ARM CM code emitters
 
+// ARM condition codes, the inverse of a condition flips its low bit
+enum {
+    CC_EQ = 0,
+    CC_NE = 1,
+    CC_MI = 4,
+    CC_HI = 8,
+    CC_LS = 9,
+    CC_GE = 10,
+    CC_LT = 11,
+    CC_GT = 12,
+    CC_LE = 13,
+    CC_AL = 14
+};
+
+// the code segment is full, which only ends the sizing of a dead function
+static void text_full(void) {
+    if (size_jmp)
+        longjmp(*size_jmp, 1);
+    fatal("code segment exceeded, program is too big");
+}
+
 static void emit(uint16_t n) {
-    if (e >= text_base + (TEXT_BYTES / sizeof(*e)) - 1)
-        fatal("code segment exceeded, program is too big");
+    if (e >= text_end - 1)
+        text_full();
     *++e = n;
     if (!nopeep_opt)
         peep();
@@ -2275,7 +3265,7 @@ static void emit2(uint16_t n1, uint16_t n2) {
 }
 
 static void emit_branch(uint16_t* to);
-static void emit_cond_branch(uint16_t* to, int cond);
+static void emit_cond_branch(uint16_t* to, int cc);
 
 static void emit_word(uint32_t n) {
     if (((int)e & 2) == 0)
@@ -2287,11 +3277,13 @@ static void emit_load_long_imm(int r, int val, int ext) {
     emit(0x4800 | (r << 8)); // ldr rr,[pc + offset n]
     struct patch_s* p = pcrel;
     while (p) {
-        if (p->val == val)
+        if (p->val == val && p->ext == ext)
             break;
         p = p->next;
     }
-    if (!p) {
+    if (p)
+        ++pool_dup;
+    else {
         ++pcrel_count;
         if (pcrel_1st == 0)
             pcrel_1st = e;
@@ -2355,6 +3347,10 @@ static void emit_nop(void) {
 static void patch_pc_relative(int brnch) {
     int rel_count = pcrel_count;
     pcrel_count = 0;
+    if (rel_count) {
+        ++pool_cnt;
+        pool_jmp += brnch;
+    }
     if (brnch) {
         if ((int)e & 2)
             emit_nop();
@@ -2368,7 +3364,7 @@ static void patch_pc_relative(int brnch) {
         while (p->locs) {
             struct patch_s* pl = p->locs;
             uint8_t b = (*pl->addr) >> 8;
-            if ((b != 0x48) && (b != 0x4b) && (b != 0xed))
+            if ((b & 0xf8) != 0x48 && b != 0xed) // ldr rx,[pc,#n] or vldr
                 fatal("unexpected compiler error");
             int te = (int)e + 2;
             int ta = (int)pl->addr + 2;
@@ -2385,31 +3381,230 @@ static void patch_pc_relative(int brnch) {
             cc_free(pl, 0);
         }
         emit_word(p->val);
-        if (ofn && p->ext) {
-            struct reloc_s* r = cc_malloc(sizeof(struct reloc_s), 1, 1);
-            r->addr = (int)(e - 1);
-            r->next = relocs;
-            relocs = r;
-            nrelocs++;
-        }
+        if (ofn && p->ext)
+            reloc_add((int)(e - 1));
         pcrel = p->next;
         cc_free(p, 0);
     }
-    pcrel_1st = 0;
+    pcrel_1st = 0;
+}
+
+static void check_pc_relative(void) {
+    if (pcrel_1st == 0)
+        return;
+    int te = (int)e + 4 * pcrel_count;
+    int ta = (int)pcrel_1st;
+    if ((te - ta) >= 960) // 64 bytes under 1024 (32 instr.)
+        patch_pc_relative(1);
+}
+
+// Called where control never falls through, after a return or an unconditional jump. A pool
+// past half its reach goes here, where it needs no branch around it.
+static void pool_barrier(void) {
+    if (pcrel_1st && ((int)e + 4 * pcrel_count - (int)pcrel_1st) >= 480)
+        patch_pc_relative(0);
+}
+
+// register holding register variable i
+static int rv_reg(int i) { return (i < 3) ? 4 + i : 8 + (i - 3); }
+
+static void emit_mov(int d, int s) {
+    emit(0x4600 | ((d & 8) << 4) | (s << 3) | (d & 7)); // mov rd,rs
+}
+
+// add -255..255 to register variable rx, leaving the result in r0 too
+static void emit_add_imm(int x, int v) {
+    int op = (v < 0) ? 0x3800 : 0x3000; // subs/adds
+    if (v < 0)
+        v = -v;
+    if (x < 8) {
+        emit(op | (x << 8) | v); // adds/subs rx,#n
+        emit_mov(0, x);
+    } else {
+        emit_mov(0, x);
+        emit(op | v); // adds/subs r0,#n
+        emit_mov(x, 0);
+    }
+}
+
+static void emit_adjust_stack(int n) {
+    if (n)
+        emit(0xb000 | n); // add sp, #n*4
+}
+
+/* With -p every function calls prof_enter once its frame is set up, and prof_leave as it
+ * returns. They count the calls and time each function with and without its callees, in
+ * microseconds, or in cycles on the CM33 which has a cycle counter. Time in a recursive function
+ * counts once toward its total. The program is not cached or saved, the calls go straight to
+ * the firmware.
+ */
+
+static struct prof_s* prof_tbl UDATA;       // function profiles
+static int prof_cnt UDATA;                  // function profiles count
+static struct prof_frame_s* prof_stk UDATA; // profiled call stack
+static int prof_sp UDATA;                   // profiled call depth, may exceed PROF_DEPTH
+
+static inline uint32_t prof_time(void) {
+#if PICO_RP2350
+    return m33_hw->dwt_cyccnt;
+#else
+    return time_us_32();
+#endif
+}
+
+static void prof_enter(int f) {
+    ++prof_tbl[f].calls;
+    if (prof_sp < PROF_DEPTH) {
+        struct prof_frame_s* s = prof_stk + prof_sp;
+        s->f = f;
+        s->sub = 0;
+        ++prof_tbl[f].active;
+        s->t0 = prof_time();
+    }
+    ++prof_sp;
 }
 
-static void check_pc_relative(void) {
-    if (pcrel_1st == 0)
+static void prof_leave(void) {
+    uint32_t t = prof_time();
+    if (--prof_sp >= PROF_DEPTH)
         return;
-    int te = (int)e + 4 * pcrel_count;
-    int ta = (int)pcrel_1st;
-    if ((te - ta) >= 960) // 64 bytes under 1024 (32 instr.)
-        patch_pc_relative(1);
+    struct prof_frame_s* s = prof_stk + prof_sp;
+    struct prof_s* p = prof_tbl + s->f;
+    uint32_t dt = t - s->t0;
+    p->self += dt - s->sub;
+    if (--p->active == 0)
+        p->total += dt;
+    if (prof_sp)
+        s[-1].sub += dt;
+}
+
+// add a profile for function id, returns its index
+static int prof_add(struct ident_s* id) {
+    int len = id->hash & 0x3f;
+    struct prof_s* t = realloc(prof_tbl, (prof_cnt + 1) * sizeof(struct prof_s));
+    char* name = malloc(len + 1);
+    if (t)
+        prof_tbl = t;
+    if (!t || !name)
+        cc_heap_short();
+    memcpy(name, id->name, len);
+    name[len] = 0;
+    memset(prof_tbl + prof_cnt, 0, sizeof(struct prof_s));
+    prof_tbl[prof_cnt].name = name;
+    return prof_cnt++;
+}
+
+static void emit_prof(int enter) {
+    if (enter) {
+        emit_load_immediate(0, prof_fn);
+        emit_load_long_imm(3, (int)prof_enter, 0);
+        emit(0x4798); // blx r3
+    } else {
+        emit(0xb401); // push {r0}, the return value
+        emit_load_long_imm(3, (int)prof_leave, 0);
+        emit(0x4798); // blx r3
+        emit(0xbc01); // pop {r0}
+    }
+}
+
+/* Global base register. A function making enough use of the globals in reach of one base,
+ * the start of the data or the latest bss variable, ranks that base with its register
+ * variables. Picked, it is loaded at entry and the globals are loaded and stored off it, and
+ * on the CM33 also addressed, rather than through an address from the literal pool. The base
+ * is an address in its segment, so it moves with the executable and offsets from it do not.
+ */
+
+#define RV_GLOBAL (-0x40000) // rv_ofs of the global base register
+
+// base of the global segment region holding address v, 0 if v is not a global
+static int gb_region(int v) {
+    if (v >= (int)data_end && v <= (int)bss_end)
+        return (int)data_end;
+    if (v >= (int)data_base && v < (int)data)
+        return (int)data_base;
+    return 0;
+}
+
+// offset of global address v from base b for an access of type t, -1 if out of reach
+static int gb_ofs(int v, int b, int t) {
+    int ofs = v - b;
+    if (!b || gb_region(v) != b)
+        return -1;
+#if PICO_RP2350
+    return (ofs < 4096) ? ofs : -1;
+#else
+    return ((t == CHAR) ? ofs < 32 : (ofs < 128 && !(ofs & 3))) ? ofs : -1;
+#endif
+}
+
+// load the global base register
+static void emit_gbase(void) {
+    if (!gb_reg)
+        return;
+    emit_load_long_imm((gb_reg < 8) ? gb_reg : 0, gb_base, 1);
+    if (gb_reg >= 8)
+        emit_mov(gb_reg, 0);
+}
+
+// load the register parameters from r7 or, if sp is set, from sp past the saved registers.
+// On the CM33 neighbouring parameters share an ldrd and r8-r11 load directly.
+static void emit_params(int sp) {
+    int done = 0;
+    for (int i = 0; i < rv_cnt; i++) {
+        if (rv_ofs[i] < 0 || (done & (1 << i)))
+            continue;
+        int ofs = sp ? rv_cnt + 1 + rv_ofs[i] - 2 : rv_ofs[i], r = rv_reg(i);
+#if PICO_RP2350
+        int j;
+        for (j = 0; j < rv_cnt && rv_ofs[j] != rv_ofs[i] + 1; j++)
+            ;
+        if (j < rv_cnt && !(done & (1 << j))) {
+            emit2(sp ? 0xe9dd : 0xe9d7, (r << 12) | (rv_reg(j) << 8) | ofs); // ldrd rx,ry,[r7,#n]
+            done |= 1 << j;
+            continue;
+        }
+        if (r >= 8) {
+            emit2(sp ? 0xf8dd : 0xf8d7, (r << 12) | (ofs << 2)); // ldr.w rx,[r7,#n]
+            continue;
+        }
+#endif
+        if (r < 8)
+            emit(sp ? 0x9800 | (r << 8) | ofs : 0x6838 | (ofs << 6) | r); // ldr rx,[r7,#n]
+        else {
+            emit(sp ? 0x9800 | ofs : 0x6838 | (ofs << 6)); // ldr r0,[r7,#n]
+            emit_mov(r, 0);
+        }
+    }
 }
 
 static void emit_enter(int n) {
-    emit(0xb580);             // push {r7,lr}
-    emit(0x466f);             // mov r7,sp
+    int lo = (rv_cnt < 3) ? rv_cnt : 3;
+    fp_calls = 0;
+    if (fp_leaf) {
+        emit_mov(12, 14); // mov ip,lr
+        return;
+    }
+    if (fp_omit) { // all variables live in registers, reach the parameters from sp
+        emit(0xb500 | (((1 << lo) - 1) << 4)); // push {r4-r6,lr}
+#if PICO_RP2350
+        if (rv_cnt > 3)
+            emit2(0xe92d, ((1 << (rv_cnt - 3)) - 1) << 8); // push.w {r8-r11}
+#endif
+        if (prof_opt)
+            emit_prof(1);
+        emit_params(1);
+        emit_gbase();
+        return;
+    }
+    emit(0xb580 | (((1 << lo) - 1) << 4)); // push {r4-r6,r7,lr}
+    if (lo)                                //
+        emit(0xaf00 | lo);                 // add r7,sp,#lo*4
+    else                                   //
+        emit(0x466f);                      // mov r7,sp
+#if PICO_RP2350
+    if (rv_cnt > 3)
+        emit2(0xe92d, ((1 << (rv_cnt - 3)) - 1) << 8); // push.w {r8-r11}
+#endif
     if (n) {                  //
         if (n < 128)          //
             emit(0xb080 | n); // sub sp,#n
@@ -2418,18 +3613,114 @@ static void emit_enter(int n) {
             emit(0x449d); // add sp,r3
         }
     }
+    if (prof_opt)
+        emit_prof(1);
+    emit_params(0);
+    emit_gbase();
 }
 
 static void emit_leave(void) {
+    if (prof_opt)
+        emit_prof(0);
+    if (fp_omit) {
+        if (fp_leaf) {
+            emit(0x4760); // bx ip
+            return;
+        }
+#if PICO_RP2350
+        if (rv_cnt > 3)
+            emit2(0xe8bd, ((1 << (rv_cnt - 3)) - 1) << 8); // pop.w {r8-r11}
+#endif
+        emit(0xbd00 | (((1 << ((rv_cnt < 3) ? rv_cnt : 3)) - 1) << 4)); // pop {r4-r6,pc}
+        return;
+    }
     emit(0x46bd); // mov sp, r7
-    emit(0xbd80); // pop {r7, pc}
+    if (rv_cnt) {
+        emit(0xb080 | rv_cnt); // sub sp,#n
+#if PICO_RP2350
+        if (rv_cnt > 3)
+            emit2(0xe8bd, ((1 << (rv_cnt - 3)) - 1) << 8); // pop.w {r8-r11}
+#endif
+    }
+    emit(0xbd80 | (((1 << ((rv_cnt < 3) ? rv_cnt : 3)) - 1) << 4)); // pop {r4-r6,r7,pc}
+}
+
+// byte offset from r7 of the frame variable at n
+static int frame_ofs(int n) {
+    if (n < 0) // locals sit below the saved registers
+        n -= rv_cnt;
+    return n * 4;
 }
 
 static void emit_load_addr(int n) {
-    emit_load_immediate(0, (n)*4);
+    if (fp_omit)
+        fatal("unexpected compiler error");
+    n = frame_ofs(n);
+#if PICO_RP2350
+    if (n > -4096 && n < 4096) {
+        int i = (n < 0) ? -n : n;
+        emit2(((n < 0) ? 0xf2a7 : 0xf207) | ((i >> 1) & 0x400),
+              ((i << 4) & 0x7000) | (i & 0xff)); // addw/subw r0,r7,#n
+        return;
+    }
+#endif
+    emit_load_immediate(0, n);
     emit(0x4438); // add r0,r7
 }
 
+// can the variable at a of type t, a global in reach of the global base or on the CM33 a frame
+// variable, be loaded and stored by a single instruction
+static int var_reach(int* a, int t) {
+    if (!a || (t != CHAR && !rv_word(t)))
+        return 0;
+    if (ast_Tk(a) == Num)
+        return gb_reg && Num_entry(a).seg && gb_ofs(Num_entry(a).val, gb_base, t) >= 0;
+#if PICO_RP2350
+    if (ast_Tk(a) == Loc && !fp_omit) {
+        int ofs = frame_ofs(Num_entry(a).val);
+        return ofs > -256 && ofs < 4096;
+    }
+#endif
+    return 0;
+}
+
+// load r0 from, or store it to, the variable at a of type t
+static void emit_var(int* a, int t, int st) {
+    int ofs, r;
+    if (ast_Tk(a) == Num) {
+        ofs = gb_ofs(Num_entry(a).val, gb_base, t);
+        r = gb_reg;
+    } else {
+        ofs = frame_ofs(Num_entry(a).val);
+        r = 7;
+    }
+    if (t != CHAR && r < 8 && ofs >= 0 && ofs < 128 && !(ofs & 3)) {
+        emit((st ? 0x6000 : 0x6800) | (ofs << 4) | (r << 3)); // str/ldr r0,[rb,#n]
+        return;
+    }
+#if PICO_RP2350
+    int op;
+    if (t != CHAR)
+        op = st ? 0xf8c0 : 0xf8d0; // str.w/ldr.w r0,[rb,#n]
+    else if (st)
+        op = 0xf880; // strb.w r0,[rb,#n]
+    else
+        op = uchar_opt ? 0xf890 : 0xf990; // ldrb.w/ldrsb.w r0,[rb,#n]
+    if (ofs >= 0)
+        emit2(op | r, ofs);
+    else
+        emit2((op & ~0x80) | r, 0x0c00 | -ofs); // negative offset form
+#else
+    if (st)
+        emit(0x7000 | (ofs << 6) | (r << 3)); // strb r0,[rb,#n]
+    else {
+        emit(0x7800 | (ofs << 6) | (r << 3)); // ldrb r0,[rb,#n]
+        if (!uchar_opt)
+            emit(0xb240); // sxtb r0,r0
+    }
+#endif
+}
+
 static void emit_push(int n) {
     emit(0xb400 | (1 << n)); // push {rn}
 }
@@ -2453,6 +3744,20 @@ static void emit_store(int n) {
     }
 }
 
+static void emit_store_reg(int n, int r) {
+    switch (n) {
+    case SC:
+        emit(0x7000 | (r << 3)); // strb r0,[rr,#0]
+        break;
+    case SI:
+    case SF:
+        emit(0x6000 | (r << 3)); // str r0,[rr,#0]
+        break;
+    default:
+        fatal("unexpected compiler error");
+    }
+}
+
 static void emit_load(int n) {
     switch (n) {
     case LC:
@@ -2481,6 +3786,7 @@ static void emit_branch(uint16_t* to) {
 
 #if PICO_RP2040
 static void emit_fop(int n) {
+    ++fp_calls;
     if (!ofn) // if exe output emit negative external function index
         emit_load_long_imm(3, (int)fops[n], 0);
     else
@@ -2489,47 +3795,23 @@ static void emit_fop(int n) {
 }
 #endif
 
-static void emit_cond_branch(uint16_t* to, int cond) {
+// branch on condition cc
+static void emit_cond_branch(uint16_t* to, int cc) {
     int ofs = to - (e + 1);
+    if (cc < CC_EQ || cc >= CC_AL)
+        fatal("unexpected compiler error");
     if (ofs >= -128 && ofs < 128) {
-        switch (cond) {
-        case BZ:
-            emit(0xd000 | (ofs & 0xff)); // be to
-            break;
-        case BNZ:
-            emit(0xd100 | (ofs & 0xff)); // bne to
-            break;
-        default:
-            fatal("unexpected compiler error");
-        }
+        emit(0xd000 | (cc << 8) | (ofs & 0xff)); // b<cc> to
         return;
     }
     if (ofs >= -1023 && ofs < 1024) {
-        switch (cond) {
-        case BZ:
-            emit(0xd100); // bne *+2
-            break;
-        case BNZ:
-            emit(0xd000); // be *+2
-            break;
-        default:
-            fatal("unexpected compiler error");
-        }
+        emit(0xd000 | ((cc ^ 1) << 8)); // b<!cc> *+2
         --ofs;
         emit(0xe000 | (ofs & 0x7ff)); // JMP to
         return;
     }
-    switch (cond) {
-    case BZ:
-        emit(0xd101); // bne *+3
-        break;
-    case BNZ:
-        emit(0xd001); // be *+3
-        break;
-    default:
-        fatal("unexpected compiler error");
-    }
-    emit_call((int)to); // JMP to
+    emit(0xd001 | ((cc ^ 1) << 8)); // b<!cc> *+3
+    emit_call((int)(to + 2));       // JMP to
 }
 
 static void emit_oper(int op) {
@@ -2795,6 +4077,285 @@ static void emit_float_oper(int op) {
     }
 }
 
+// Register operand forms of emit_oper and emit_float_oper: r0 = rl op rr, where one of rl and
+// rr is r0 and the other holds the register stack operand. Only r3 and the operand register
+// are used as scratch.
+
+static void emit_oper_reg(int op, int rl, int rr) {
+    int s = rl | rr; // the non r0 operand
+    switch (op) {
+    case OR:
+        emit(0x4300 | (s << 3)); // orrs r0,rs
+        break;
+    case XOR:
+        emit(0x4040 | (s << 3)); // eors r0,rs
+        break;
+    case AND:
+        emit(0x4000 | (s << 3)); // ands r0,rs
+        break;
+    case ADD:
+        emit(0x1800 | (s << 6)); // adds r0,r0,rs
+        break;
+    case MUL:
+        emit(0x4340 | (s << 3)); // muls r0,rs
+        break;
+    case SUB:
+        emit(0x1a00 | (rr << 6) | (rl << 3)); // subs r0,rl,rr
+        break;
+    case SHL:
+    case SHR:
+        if (rl) {
+            emit(((op == SHL) ? 0x4080 : 0x4100) | rl); // lsls/asrs rl,r0
+            emit(rl << 3);                              // movs r0,rl
+        } else
+            emit(((op == SHL) ? 0x4080 : 0x4100) | (rr << 3)); // lsls/asrs r0,rr
+        break;
+    case EQ:
+        emit(0x1a00 | (s << 3)); // subs r0,rs,r0
+        emit(0x4243);            // negs r3,r0
+        emit(0x4158);            // adcs r0,r3
+        break;
+    case NE:
+        emit(0x1a00 | (s << 3)); // subs r0,rs,r0
+        emit(0x1e43);            // subs r3,r0,#1
+        emit(0x4198);            // sbcs r0,r3
+        break;
+    case GE:
+    case LT:
+    case GT:
+    case LE:
+#if PICO_RP2350
+        emit(0x4280 | (rr << 3) | rl); // cmp rl,rr
+        switch (op) {
+        case GE:
+            emit(0xbfb4); // ite lt
+            break;
+        case LT:
+            emit(0xbfac); // ite ge
+            break;
+        case GT:
+            emit(0xbfd4); // ite le
+            break;
+        default:
+            emit(0xbfcc); // ite gt
+        }
+        emit(0x2000); // movxx r0,#0
+        emit(0x2001); // movxx r0,#1
+#else
+        emit(0x2301);                  // movs r3,#1
+        emit(0x4280 | (rr << 3) | rl); // cmp  rl,rr
+        switch (op) {
+        case GE:
+            emit(0xda00); // bge.n L1
+            break;
+        case LT:
+            emit(0xdb00); // blt.n L1
+            break;
+        case GT:
+            emit(0xdc00); // bgt.n L1
+            break;
+        default:
+            emit(0xdd00); // ble.n L1
+        }
+        emit(0x2300); // movs r3,#0
+                      // L1:
+        emit(0x0018); // movs r0,r3
+#endif
+        break;
+#if PICO_RP2350
+    case DIV:
+        emit2(0xfb90 | rl, 0xf0f0 | rr); // sdiv r0,rl,rr
+        break;
+    case MOD:
+        emit2(0xfb90 | rl, 0xf3f0 | rr);         // sdiv r3,rl,rr
+        emit2(0xfb03, (rl << 12) | 0x0010 | rr); // mls r0,r3,rr,rl
+        break;
+#endif
+    default:
+        fatal("unexpected compiler error");
+    }
+}
+
+static void emit_float_oper_reg(int op, int rl, int rr) {
+#if PICO_RP2350
+    emit2(0xee07, (rr << 12) | 0x0a90); // vmov s15,rr
+    emit2(0xee07, (rl << 12) | 0x0a10); // vmov s14,rl
+    switch (op) {
+    case ADDF:
+        emit2(0xee77, 0x7a27); // vadd.f32 s15,s14,s15
+        break;
+    case SUBF:
+        emit2(0xee77, 0x7a67); // vsub.f32 s15,s14,s15
+        break;
+    case MULF:
+        emit2(0xee67, 0x7a27); // vmul.f32 s15,s14,s15
+        break;
+    case DIVF:
+        emit2(0xeec7, 0x7a27); // vdiv.f32 s15,s14,s15
+        break;
+    default:
+        emit2(0xeeb4, 0x7ae7); // vcmpe.f32 s14,s15
+        emit2(0xeef1, 0xfa10); // vmrs APSR_nzcv,fpscr
+        switch (op) {
+        case GEF:
+            emit(0xbfac); // ite ge
+            break;
+        case GTF:
+            emit(0xbfcc); // ite gt
+            break;
+        case LTF:
+            emit(0xbf4c); // ite lt
+            break;
+        case LEF:
+            emit(0xbf94); // ite le
+            break;
+        case EQF:
+            emit(0xbf0c); // ite eq
+            break;
+        case NEF:
+            emit(0xbf14); // ite ne
+            break;
+        default:
+            fatal("unexpected compiler error");
+        }
+        emit(0x2001); // mov r0,#1
+        emit(0x2000); // mov r0,#0
+        return;
+    }
+    emit_float_suffix();
+#else
+    switch (op) {
+    case EQF:
+        emit_oper_reg(EQ, rl, rr);
+        break;
+    case NEF:
+        emit_oper_reg(NE, rl, rr);
+        break;
+    default:
+        fatal("unexpected compiler error");
+    }
+#endif
+}
+
+#if PICO_RP2350
+// magic multiplier of the signed division by d > 1 and its shift, Hacker's Delight 10-1
+static int div_magic(int d, int* sh) {
+    uint32_t t = 0x80000000u, anc = t - 1 - t % d, q1 = t / anc, r1 = t - q1 * anc;
+    uint32_t q2 = t / d, r2 = t - q2 * d, delta;
+    int p = 31;
+    do {
+        ++p;
+        q1 <<= 1;
+        r1 <<= 1;
+        if (r1 >= anc) {
+            ++q1;
+            r1 -= anc;
+        }
+        q2 <<= 1;
+        r2 <<= 1;
+        if (r2 >= (uint32_t)d) {
+            ++q2;
+            r2 -= d;
+        }
+        delta = d - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    *sh = p - 32;
+    return q2 + 1;
+}
+#endif
+
+// Divide r0 by the constant c, neither 0 nor INT_MIN, leaving the quotient in r0 if quo, and
+// if rem the remainder in r0, or in rs when the quotient is wanted too. rs is free, r3 scratch.
+// A power of 2 shifts, biasing a negative dividend to truncate toward zero. Otherwise the
+// RP2350 multiplies by a fixed point reciprocal, and the RP2040, lacking a multiply high,
+// runs the SIO divider inline, calling the runtime when the interrupted code left it dirty.
+static void emit_div_const(int c, int rs, int quo, int rem) {
+    int d = (c < 0) ? -c : c, k = __builtin_ctz(d);
+    if (d == (1 << k)) {
+        if (k == 1)
+            emit(0x0fc3); // lsrs r3,r0,#31
+        else if (k) {
+            emit(0x17c3);                   // asrs r3,r0,#31
+            emit(0x081b | ((32 - k) << 6)); // lsrs r3,r3,#32-k
+        }
+        if (!rem) {
+            if (k) {
+                emit(0x18c0);            // adds r0,r0,r3
+                emit(0x1000 | (k << 6)); // asrs r0,r0,#k
+            }
+        } else if (!k)
+            emit(0x2000 | ((quo ? rs : 0) << 8)); // movs rx,#0
+        else {
+            emit(0x18c3);            // adds r3,r0,r3
+            emit(0x101b | (k << 6)); // asrs r3,r3,#k
+            if (quo) {
+                emit(0x0018 | (k << 6) | rs);  // lsls rs,r3,#k
+                emit(0x1a00 | (rs << 6) | rs); // subs rs,r0,rs
+                emit_mov(0, 3);
+            } else {
+                emit(0x001b | (k << 6)); // lsls r3,r3,#k
+                emit(0x1ac0);            // subs r0,r0,r3
+            }
+        }
+        if (quo && c < 0)
+            emit(0x4240); // negs r0,r0
+        return;
+    }
+#if PICO_RP2350
+    int sh, m = div_magic(d, &sh);
+    emit_load_immediate(3, m);
+    emit2(0xfb50, 0xf303); // smmul r3,r0,r3
+    if (m < 0)
+        emit(0x181b); // adds r3,r3,r0
+    if (sh)
+        emit(0x101b | (sh << 6)); // asrs r3,r3,#sh
+    if (!rem)
+        emit2(0xeba3, 0x70e0); // sub.w r0,r3,r0,asr #31
+    else {
+        emit2(0xeba3, 0x73e0); // sub.w r3,r3,r0,asr #31
+        emit_load_immediate(rs, d);
+        if (!quo) {
+            emit2(0xfb03, 0x0010 | rs); // mls r0,r3,rs,r0
+            return;
+        }
+        emit2(0xfb03, (rs << 8) | 0x0010 | rs); // mls rs,r3,rs,r0
+        emit_mov(0, 3);
+    }
+    if (c < 0)
+        emit(0x4240); // negs r0,r0
+#else
+    uint16_t *slow, *done;
+    int live = (1 << rs) - 2;      // r1 to rs-1
+    emit(0x23d0);                  // movs r3,#0xd0
+    emit(0x061b);                  // lsls r3,r3,#24, SIO base
+    emit(0x6f98 | rs);             // ldr rs,[r3,#0x78], DIV_CSR
+    emit(0x0880 | (rs << 3) | rs); // lsrs rs,rs,#2, DIRTY
+    slow = e + 1;
+    emit(0xd200); // bcs slow
+    emit(0x6698); // str r0,[r3,#0x68], DIV_SDIVIDEND
+    emit_load_immediate(rs, c);
+    emit(0x66d8 | rs);        // str rs,[r3,#0x6c], DIV_SDIVISOR
+    emit(0x2003 | (rs << 8)); // movs rs,#3, the result takes 8 cycles
+    emit(0x3801 | (rs << 8)); // subs rs,#1
+    emit(0xd1fd);             // bne .-2
+    if (rem)
+        emit(0x6f58 | (quo ? rs : 0)); // ldr rx,[r3,#0x74], DIV_REMAINDER
+    emit(0x6f18 | (quo ? 0 : 3));      // ldr rx,[r3,#0x70], DIV_QUOTIENT, read last
+    done = e + 1;
+    emit(0xe000); // b done
+    *slow |= (e + 1 - (slow + 2)) & 0xff;
+    if (live)
+        emit(0xb400 | live); // push {r1..}
+    emit_load_immediate(1, c);
+    emit_fop(aeabi_idiv); // quotient in r0, remainder in r1
+    if (rem && (quo ? rs : 0) != 1)
+        emit_mov(quo ? rs : 0, 1);
+    if (live)
+        emit(0xbc00 | live); // pop {r1..}
+    *done |= (e + 1 - (done + 2)) & 0x7ff;
+#endif
+}
+
 static void emit_cast(int n) {
     switch (n) {
     case ITOF:
@@ -2820,17 +4381,9 @@ static void emit_cast(int n) {
     }
 }
 
-static void emit_adjust_stack(int n) {
-    if (n)
-        emit(0xb000 | n); // add sp, #n*4
-}
-
-static uint16_t* emit_call(int n) {
-    if (n == 0) {
-        emit2(0, 0);
-        return e - 1;
-    }
-    int ofs = (n - ((int)e + 6)) / 2;
+// encoding of a BL at address at to address n, first halfword in the upper half
+static uint32_t bl_code(int at, int n) {
+    int ofs = (n - (at + 4)) / 2;
     if (ofs < -8388608 || ofs > 8388607)
         fatal("subroutine call too far");
     int s = (ofs >> 31) & 1;
@@ -2840,13 +4393,32 @@ static uint16_t* emit_call(int n) {
     int j2 = s ^ i2;
     int i11 = ofs & ((1 << 11) - 1);
     int i10 = (ofs >> 11) & ((1 << 10) - 1);
-    emit(0xf000 | (s << 10) | i10);
-    emit(0xd000 | (j1 << 13) | (j2 << 11) | i11);
+    return ((0xf000 | (s << 10) | i10) << 16) | (0xd000 | (j1 << 13) | (j2 << 11) | i11);
+}
+
+// target address of the BL at address at
+static int bl_target(int at, uint16_t h1, uint16_t h2) {
+    int s = (h1 >> 10) & 1;
+    int ofs = ((h1 & 0x3ff) << 11) | (h2 & 0x7ff);
+    ofs |= ((((h2 >> 13) & 1) ^ s ^ 1) << 22) | ((((h2 >> 11) & 1) ^ s ^ 1) << 21);
+    if (s)
+        ofs |= -1 << 23;
+    return at + 4 + ofs * 2;
+}
+
+static uint16_t* emit_call(int n) {
+    if (n == 0) {
+        emit2(0, 0);
+        return e - 1;
+    }
+    uint32_t c = bl_code((int)(e + 1), n);
+    emit2(c >> 16, c & 0xffff);
     return e - 1;
 }
 
 static void emit_syscall(int n, int np) {
     const struct externs_s* p = externs + n;
+    ++fp_calls;
     if (IS_PRINTF(p)) {
         emit_load_immediate(0, np);
         if (!ofn)
@@ -2888,19 +4460,827 @@ static void emit_syscall(int n, int np) {
     }
 }
 
-static void patch_branch(uint16_t* from, uint16_t* to) {
-    if (*from != 0 || *(from + 1) != 0)
-        fatal("unexpected compiler error");
-    uint16_t* se = e;
-    e = from - 1;
-    emit_call((int)to);
-    e = se;
+static void patch_branch(uint16_t* from, uint16_t* to) {
+    if (*from != 0 || *(from + 1) != 0)
+        fatal("unexpected compiler error");
+    uint16_t* se = e;
+    e = from - 1;
+    emit_call((int)to);
+    e = se;
+}
+
+// divisor of the division or modulus by a constant at a, else 0
+static int div_const(int* a) {
+    if ((ast_Tk(a) != Div && ast_Tk(a) != Mod) || ast_Tk(a + Oper_words) != Num)
+        return 0;
+    return (Num_entry(a + Oper_words).val == INT_MIN) ? 0 : Num_entry(a + Oper_words).val;
+}
+
+// constant division that can fall back to a runtime call
+static int div_call(int* a) {
+#if PICO_RP2040
+    int c = div_const(a);
+    if (c < 0)
+        c = -c;
+    return (c & (c - 1)) != 0; // not a power of 2
+#else
+    return 0;
+#endif
+}
+
+// Register variable selection. Scalar int, float and pointer locals and parameters whose
+// address is never taken are ranked by use count, weighted by loop depth, and the busiest
+// live in callee saved registers for the whole function. When they all fit the function
+// needs no frame pointer, and a function that also makes no calls keeps lr in ip.
+
+static int rs_call(int* a);
+
+static int rv_word(int t) { return t == INT || t == FLOAT || t >= PTR; }
+
+static void rv_count(int* a, int w, int ok) {
+    int* u = rv_use + Num_entry(a).val + rv_bias;
+    if (!ok)
+        *u = -1;
+    else if (*u >= 0)
+        *u += w;
+}
+
+// count a use of the global at Num node a by a t access
+static void gb_count(int* a, int t, int w) {
+    int b = gb_region(Num_entry(a).val);
+    if (Num_entry(a).seg && (t == CHAR || rv_word(t)) && gb_ofs(Num_entry(a).val, b, t) >= 0)
+        gb_use[b == (int)data_base] += w;
+}
+
+static void rv_scan(int* a, int w) {
+    int* b;
+    if (a == 0)
+        return;
+    switch (ast_Tk(a)) {
+    case Loc: // address used directly
+        rv_count(a, w, 0);
+        break;
+#if PICO_RP2350
+    case Num: // address formed off the global base
+        gb_count(a, CHAR, w);
+        break;
+#endif
+    case Load:
+        if (ast_Tk(a + Load_words) == Loc)
+            rv_count(a + Load_words, w, rv_word(Load_entry(a).typ));
+        else if (ast_Tk(a + Load_words) == Num)
+            gb_count(a + Load_words, Load_entry(a).typ, w);
+        else
+            rv_scan(a + Load_words, w);
+        break;
+    case Assign:
+        b = (int*)Assign_entry(a).right_part;
+        if (ast_Tk(b) == Loc)
+            rv_count(b, w, rv_word(Assign_entry(a).type & 0xffff));
+        else if (ast_Tk(b) == Num)
+            gb_count(b, Assign_entry(a).type & 0xffff, w);
+        else
+            rv_scan(b, w);
+        rv_scan(a + Assign_words, w);
+#if PICO_RP2040
+        if (((Assign_entry(a).type >> 16) == FLOAT) != ((Assign_entry(a).type & 0xffff) == FLOAT))
+            rv_call = 1; // conversion call
+#endif
+        break;
+    case Inc:
+    case Dec:
+        if (ast_Tk(a + Oper_words) == Loc)
+            rv_count(a + Oper_words, w, Num_entry(a).val != CHAR);
+        else if (ast_Tk(a + Oper_words) == Num)
+            gb_count(a + Oper_words, (Num_entry(a).val == CHAR) ? CHAR : INT, w);
+        else
+            rv_scan(a + Oper_words, w);
+        break;
+    case '{':
+        rv_scan(Begin_entry(a).next, w);
+        rv_scan(a + Begin_words, w);
+        break;
+    case '(':
+        rv_scan((int*)Double_entry(a).v1, w);
+        break;
+    case Cond:
+        rv_scan((int*)Cond_entry(a).cond_part, w);
+        rv_scan((int*)Cond_entry(a).if_part, w);
+        rv_scan((int*)Cond_entry(a).else_part, w);
+        break;
+    case CastF:
+        rv_scan((int*)CastF_entry(a).val, w);
+#if PICO_RP2040
+        rv_call = 1;
+#endif
+        break;
+    case Func:
+    case Syscall:
+        rv_call = 1;
+        for (b = (int*)Func_entry(a).next; b; b = (int*)ast_Tk(b))
+            rv_scan(b + Single_words, w);
+        break;
+    case While:
+    case DoWhile:
+        if (w < (1 << 12))
+            w *= 8;
+        rv_scan((int*)While_entry(a).cond, w);
+        rv_scan((int*)While_entry(a).body, w);
+        break;
+    case For:
+        rv_scan((int*)For_entry(a).init, w);
+        if (w < (1 << 12))
+            w *= 8;
+        rv_scan((int*)For_entry(a).cond, w);
+        rv_scan((int*)For_entry(a).body, w);
+        rv_scan((int*)For_entry(a).incr, w);
+        break;
+    case Switch:
+        rv_scan((int*)Switch_entry(a).cond, w);
+        rv_scan((int*)Switch_entry(a).cas, w);
+        break;
+    case Case:
+        rv_scan((int*)Case_entry(a).next, w);
+        rv_scan((int*)Case_entry(a).expr, w);
+        break;
+    case Default:
+    case Return:
+        rv_scan((int*)Double_entry(a).v1, w);
+        break;
+    case Enter:
+        rv_scan(a + Enter_words, w);
+        break;
+    default:
+        if (ast_Tk(a) >= Lor && ast_Tk(a) <= LeF) { // binary operators
+            rv_scan((int*)Oper_entry(a).oprnd, w);
+            rv_scan(a + Oper_words, w);
+            if (rs_call(a) || div_call(a))
+                rv_call = 1;
+        }
+    }
+}
+
+// pick the register variables of the function whose AST is at a
+static void rv_select(int* a, int nlocs, int nparms) {
+    int sz = nlocs + nparms + 2;
+    rv_cnt = rv_call = fp_omit = fp_leaf = gb_reg = 0;
+    if (nopeep_opt)
+        return;
+    rv_bias = nlocs;
+    rv_use = cc_malloc((sz + 1) * sizeof(int), 1, 1);
+    gb_use[0] = gb_use[1] = 0;
+    rv_scan(a, 1);
+    // can every variable the function uses live in a register?
+    int used = 0;
+    fp_omit = 1;
+    for (int i = 0; i < sz; i++)
+        if (rv_use[i] < 0)
+            fp_omit = 0;
+        else if (rv_use[i])
+            ++used;
+    if (used > REG_VARS)
+        fp_omit = 0;
+    // the global base ranks last in the table, worth a register from two uses but not the
+    // frame pointer
+    int g = gb_use[1] > gb_use[0];
+    gb_base = g ? (int)data_base : (int)data_end;
+    if (gb_use[g] >= 2 && !(fp_omit && used == REG_VARS))
+        rv_use[sz] = gb_use[g];
+    ++sz;
+    while (rv_cnt < REG_VARS) {
+        int best = 0;
+        for (int i = 1; i < sz; i++)
+            if (rv_use[i] > rv_use[best])
+                best = i;
+        int w = rv_use[best], ofs = best - rv_bias;
+        if (w < (fp_omit ? 1 : 2))
+            break;
+        rv_use[best] = -1;
+        if (best == sz - 1) {
+            gb_reg = rv_reg(rv_cnt);
+            rv_ofs[rv_cnt++] = RV_GLOBAL;
+        }
+        // a parameter pays an extra load at entry and must be reachable from r7
+        else if (fp_omit || ofs < 0 || (w >= 3 && ofs <= 31))
+            rv_ofs[rv_cnt++] = ofs;
+    }
+    fp_leaf = fp_omit && !rv_call && !rv_cnt && !prof_opt; // the profiler calls clobber lr
+    cc_free(rv_use, 0);
+    rv_use = NULL;
+}
+
+// register of the register variable at Loc node a, 0 if in memory
+static int rv_find(int* a) {
+    if (ast_Tk(a) != Loc)
+        return 0;
+    for (int i = 0; i < rv_cnt; i++)
+        if (rv_ofs[i] == Num_entry(a).val)
+            return rv_reg(i);
+    return 0;
+}
+
+// Expression register stack. A binary operator keeps its first operand in r1 or r2 rather
+// than pushing it, provided the other operand can be evaluated in the remaining registers
+// without a call. Operands are ordered by Sethi-Ullman number; r3 stays a scratch register.
+
+#define RS_SLOTS 2  // r1-r2
+#define RS_SPILL 99 // subtree needs the stack
+
+// operator at a implemented by a runtime call, which clobbers r0-r3
+static int rs_call(int* a) {
+#if PICO_RP2040
+    int tk = ast_Tk(a);
+    if (div_const(a)) // inline, saving the registers around its fallback call
+        return 0;
+    return tk == Div || tk == Mod || (tk >= AddF && tk <= LeF && tk != EqF && tk != NeF);
+#else
+    return 0;
+#endif
+}
+
+static int rs_max(int a, int b) { return (a > b) ? a : b; }
+
+// registers needed to evaluate the AST at a, clears *pure if it has side effects
+static int rs_need(int* a, int* pure) {
+    int l, r, pl = 1, pr = 1, *b;
+    switch (ast_Tk(a)) {
+    case Num:
+    case NumF:
+    case Loc:
+    case Id:
+    case ';':
+        return 0;
+    case '(':
+        return rs_need((int*)Double_entry(a).v1, pure);
+    case Load:
+        if (ast_Tk(a + Load_words) == ';') // compound assignment reuses r0
+            *pure = 0;
+        return rs_need(a + Load_words, pure);
+    case Assign:
+        *pure = 0;
+        b = (int*)Assign_entry(a).right_part;
+        r = rs_need(a + Assign_words, pure);
+#if PICO_RP2040
+        if (((Assign_entry(a).type >> 16) == FLOAT) != ((Assign_entry(a).type & 0xffff) == FLOAT))
+            return RS_SPILL; // conversion call
+#endif
+        if (rv_find(b))
+            return r;
+        return rs_max(rs_need(b, pure), r + 1);
+    case Inc:
+    case Dec:
+        *pure = 0;
+        if (rv_find(a + Oper_words))
+            return 0;
+        return rs_max(rs_need(a + Oper_words, pure), 1);
+    case Cond:
+        l = rs_max(rs_need((int*)Cond_entry(a).cond_part, pure),
+                   rs_need((int*)Cond_entry(a).if_part, pure));
+        if (Cond_entry(a).else_part)
+            l = rs_max(l, rs_need((int*)Cond_entry(a).else_part, pure));
+        return l;
+    case Lor:
+    case Lan:
+        return rs_max(rs_need((int*)Oper_entry(a).oprnd, pure), rs_need(a + Oper_words, pure));
+    case CastF:
+        l = rs_need((int*)CastF_entry(a).val, pure);
+#if PICO_RP2040
+        l = RS_SPILL;
+#endif
+        return l;
+    default:
+        if (ast_Tk(a) < Or || ast_Tk(a) > LeF) { // calls and statements
+            *pure = 0;
+            return RS_SPILL;
+        }
+        l = rs_need((int*)Oper_entry(a).oprnd, &pl);
+        r = rs_need(a + Oper_words, &pr);
+        *pure &= pl & pr;
+        if (rs_call(a))
+            return RS_SPILL;
+        if (pl && pr && l < r) // right operand first
+            return rs_max(r, l + 1);
+        return rs_max(l, r + 1);
+    }
+}
+
+static void gen(int* n);
+
+// evaluate the AST at a into register r, directly for simple operands
+static void gen_to(int* a, int r) {
+    int k, *b = a + Load_words;
+    if (ast_Tk(a) == Num && Num_entry(a).val >= 0 && Num_entry(a).val < 256)
+        emit(0x2000 | (r << 8) | Num_entry(a).val); // movs rr,#n
+    else if (ast_Tk(a) == Load && (k = rv_find(b)))
+        emit_mov(r, k);
+    else if (ast_Tk(a) == Load && ast_Tk(b) == Loc && rv_word(Load_entry(a).typ) &&
+             Num_entry(b).val > 0 && Num_entry(b).val < 32)
+        emit(0x6838 | (Num_entry(b).val << 6) | r); // ldr rr,[r7,#n]
+    else {
+        gen(a);
+        emit_mov(r, 0);
+    }
+}
+
+// evaluate the operands l and r of a binary operator, by a runtime call if call is set,
+// returns the l register in bits 4-7 and the r one in bits 0-3, one of them r0, or -1 with
+// l pushed
+static int gen_pair(int* l, int* r, int call) {
+    int pl = 1, pr = 1;
+    int nl = rs_need(l, &pl), nr = rs_need(r, &pr);
+    int free = RS_SLOTS - rs_depth, s = rs_depth + 1;
+    if (!call && rs_max(nl, nr + 1) <= free && !(pl && pr && nl < nr)) { // left operand first
+        gen_to(l, s);
+        ++rs_depth;
+        gen(r);
+        --rs_depth;
+        return s << 4;
+    }
+    if (!call && pl && pr && rs_max(nr, nl + 1) <= free) {
+        gen_to(r, s); // right operand first
+        ++rs_depth;
+        gen(l);
+        --rs_depth;
+        return s;
+    }
+    if (rs_depth) // spill to the stack
+        fatal("unexpected compiler error");
+    gen(l);
+    emit_push(0);
+    gen(r);
+    return -1;
+}
+
+// evaluate the operands of the binary operator at n, as gen_pair
+static int gen_operands(int* n) {
+    return gen_pair((int*)Oper_entry(n).oprnd, n + Oper_words, rs_call(n));
+}
+
+// binary operator
+static void gen_oper(int* n, int op, int flt) {
+    int r = gen_operands(n);
+    if (r < 0) {
+        if (flt)
+            emit_float_oper(op);
+        else
+            emit_oper(op);
+    } else if (flt)
+        emit_float_oper_reg(op, r >> 4, r & 15);
+    else
+        emit_oper_reg(op, r >> 4, r & 15);
+}
+
+// load at n through the sum of two registers, ldr or ldrb/ldrsb r0,[rl,rr], and on the CM33
+// ldr.w r0,[rl,rr,lsl #2] for a word index, returns 0 if it does not apply
+static int gen_load_index(int* n) {
+    int t = Num_entry(n).val, *a = n + Load_words, *x = a + Oper_words, r;
+    if (ast_Tk(a) != Add || (t != CHAR && !rv_word(t)))
+        return 0;
+    if (ast_Tk(x) == Num) // constant offset
+        return 0;
+#if PICO_RP2350
+    if (t != CHAR && ast_Tk(x + Oper_words) == Num &&
+        ((ast_Tk(x) == Mul && Num_entry(x + Oper_words).val == 4) ||
+         (ast_Tk(x) == Shl && Num_entry(x + Oper_words).val == 2))) {
+        if ((r = gen_pair((int*)Oper_entry(a).oprnd, (int*)Oper_entry(x).oprnd, 0)) < 0) {
+            emit_pop(1);
+            r = 1 << 4;
+        }
+        emit2(0xf850 | (r >> 4), 0x0020 | (r & 15)); // ldr.w r0,[rl,rr,lsl #2]
+        return 1;
+    }
+#endif
+    if ((r = gen_operands(a)) < 0) {
+        emit_pop(1);
+        r = 1 << 4;
+    }
+    r = ((r & 15) << 6) | ((r >> 4) << 3);
+    if (t != CHAR)
+        emit(0x5800 | r); // ldr r0,[rl,rr]
+    else if (uchar_opt)
+        emit(0x5c00 | r); // ldrb r0,[rl,rr]
+    else
+        emit(0x5600 | r); // ldrsb r0,[rl,rr]
+    return 1;
+}
+
+#if PICO_RP2350
+// sum with a product at n by mla, the addend in r1 and the factors in r2 and r0, returns 0 if
+// it does not apply
+static int gen_mla(int* n) {
+    int *z = (int*)Oper_entry(n).oprnd, *m = n + Oper_words, *x, *y, p = 1;
+    if (ast_Tk(m) != Mul) {
+        m = z;
+        z = n + Oper_words;
+    }
+    if (ast_Tk(m) != Mul || rs_depth)
+        return 0;
+    x = (int*)Oper_entry(m).oprnd;
+    y = m + Oper_words;
+    if (rs_need(z, &p) > 2 || rs_need(x, &p) > 1 || rs_need(y, &p) || !p)
+        return 0;
+    gen_to(z, 1);
+    rs_depth = 1;
+    gen_to(x, 2);
+    rs_depth = 2;
+    gen(y);
+    rs_depth = 0;
+    emit2(0xfb00, 0x1002); // mla r0,r0,r2,r1
+    return 1;
+}
+#endif
+
+/* A condition tested by if, while or for sets the flags for its branch, by cmp or by vcmpe
+ * and vmrs on the CM33, instead of leaving 0 or 1 in r0 to compare with 0. Float comparisons
+ * on the CM0+ still produce the value. Unordered floats fail every test but !=, hence mi and
+ * ls for < and <=.
+ */
+
+// evaluate the condition at a into the flags, returns the condition code holding when it is true
+static int gen_cond(int* a) {
+    int cc, r, k, *l, *v;
+    switch (ast_Tk(a)) {
+    case Eq:
+        cc = CC_EQ;
+        break;
+    case Ne:
+        cc = CC_NE;
+        break;
+    case Lt:
+        cc = CC_LT;
+        break;
+    case Ge:
+        cc = CC_GE;
+        break;
+    case Gt:
+        cc = CC_GT;
+        break;
+    case Le:
+        cc = CC_LE;
+        break;
+#if PICO_RP2350
+    case EqF:
+        cc = CC_EQ;
+        break;
+    case NeF:
+        cc = CC_NE;
+        break;
+    case LtF:
+        cc = CC_MI;
+        break;
+    case GeF:
+        cc = CC_GE;
+        break;
+    case GtF:
+        cc = CC_GT;
+        break;
+    case LeF:
+        cc = CC_LS;
+        break;
+#endif
+    default:
+        gen(a);
+        emit(0x2800); // cmp r0,#0
+        return CC_NE;
+    }
+    l = (int*)Oper_entry(a).oprnd;
+    v = a + Oper_words;
+    if (ast_Tk(a) >= Eq && ast_Tk(a) <= Le && ast_Tk(v) == Num && Num_entry(v).val >= 0 &&
+        Num_entry(v).val < 256) { // small constant
+        if (ast_Tk(l) != Load || !(k = rv_find(l + Load_words)) || k > 7) {
+            gen(l);
+            k = 0;
+        }
+        emit(0x2800 | (k << 8) | Num_entry(v).val); // cmp rk,#n
+        return cc;
+    }
+    if ((r = gen_operands(a)) < 0) {
+        emit_pop(1);
+        r = 1 << 4;
+    }
+    if (ast_Tk(a) >= Eq && ast_Tk(a) <= Le) {
+        emit(0x4280 | ((r & 15) << 3) | (r >> 4)); // cmp rl,rr
+        return cc;
+    }
+#if PICO_RP2350
+    emit2(0xee07, ((r & 15) << 12) | 0x0a90); // vmov s15,rr
+    emit2(0xee07, ((r >> 4) << 12) | 0x0a10); // vmov s14,rl
+    emit2(0xeeb4, 0x7ae7);                    // vcmpe.f32 s14,s15
+    emit2(0xeef1, 0xfa10);                    // vmrs APSR_nzcv,fpscr
+#endif
+    return cc;
+}
+
+#if PICO_RP2350
+// instruction setting r0 to the value of the AST at a, 0 if it takes more than one
+static int it_arm(int* a) {
+    int k;
+    if (ast_Tk(a) == Num && Num_entry(a).val >= 0 && Num_entry(a).val < 256)
+        return 0x2000 | Num_entry(a).val; // movs r0,#n
+    if (ast_Tk(a) == Load && (k = rv_find(a + Load_words)))
+        return 0x4600 | (k << 3); // mov r0,rk
+    return 0;
+}
+
+// conditional at n choosing between two single instruction values by an IT block, returns 0
+// if it does not apply
+static int gen_it(int* n) {
+    int t, f;
+    if (!Cond_entry(n).else_part || !(t = it_arm((int*)Cond_entry(n).if_part)) ||
+        !(f = it_arm((int*)Cond_entry(n).else_part)))
+        return 0;
+    int cc = gen_cond((int*)Cond_entry(n).cond_part);
+    emit(0xbf04 | (cc << 4) | ((~cc & 1) << 3)); // ite cc
+    emit(t);
+    emit(f);
+    return 1;
+}
+#endif
+
+// register variable dividend of the statement at s when it assigns a register variable the
+// quotient or remainder of it by a constant, else 0
+static int div_src(int* s) {
+    int *v = s + Assign_words, *x, k;
+    if (ast_Tk(s) != Assign || Assign_entry(s).type != ((INT << 16) | INT) || !div_const(v) ||
+        !(k = rv_find((int*)Assign_entry(s).right_part)))
+        return 0;
+    x = (int*)Oper_entry(v).oprnd;
+    if (ast_Tk(x) != Load)
+        return 0;
+    if (ast_Tk(x + Load_words) == ';') // compound assignment
+        return k;
+    return rv_find(x + Load_words);
+}
+
+// statement list at n ending in the quotient and remainder of the same division, such as
+// q = x / 10; r = x % 10;, dividing once, returns 0 if not
+static int gen_divmod(int* n) {
+    int *s1 = Begin_entry(n).next, *s2 = n + Begin_words, *p, *v1, *v2, x, a;
+    if (rs_depth || ast_Tk(s1) != '{')
+        return 0;
+    p = Begin_entry(s1).next;
+    s1 += Begin_words;
+    v1 = s1 + Assign_words;
+    v2 = s2 + Assign_words;
+    if (!(x = div_src(s2)) || div_src(s1) != x || ast_Tk(v1) == ast_Tk(v2) ||
+        div_const(v1) != div_const(v2))
+        return 0;
+    a = rv_find((int*)Assign_entry(s1).right_part);
+    if (a == x) // the second statement divides the new value
+        return 0;
+    gen(p);
+    emit_mov(0, x);
+    emit_div_const(div_const(v1), 1, 1, 1);
+    emit_mov(a, (ast_Tk(v1) == Div) ? 0 : 1);
+    emit_mov(rv_find((int*)Assign_entry(s2).right_part), (ast_Tk(v2) == Div) ? 0 : 1);
+    if (ast_Tk(v2) == Mod) // the value of the list
+        emit_mov(0, 1);
+    return 1;
+}
+
+/* A switch statement dispatches on its value in r0 before its body is generated. Case labels
+ * dense enough index a jump table of halfword offsets, TBH on the CM33 and a table load added
+ * to pc on the CM0+. The others are found by a binary search over the sorted labels, comparing
+ * the last few in turn. The dispatch jumps and the table entries are filled in once the body
+ * has placed the labels.
+ */
+
+#define SW_TABLE_MIN 4   // case labels before a jump table is considered
+#define SW_TABLE_MAX 256 // jump table entries, keeps a literal pool in reach across the table
+#define SW_DENSITY 3     // jump table entries per case label at most
+#define SW_LINEAR 3      // case labels compared in turn at the leaves of the search
+
+// count the case labels of the switch body at a, storing their values once sw_case is set
+static void sw_scan(int* a) {
+    if (a == 0)
+        return;
+    switch (ast_Tk(a)) {
+    case '{':
+        sw_scan(Begin_entry(a).next);
+        sw_scan(a + Begin_words);
+        break;
+    case Cond:
+        sw_scan((int*)Cond_entry(a).if_part);
+        sw_scan((int*)Cond_entry(a).else_part);
+        break;
+    case While:
+    case DoWhile:
+        sw_scan((int*)While_entry(a).body);
+        break;
+    case For:
+        sw_scan((int*)For_entry(a).body);
+        break;
+    case Case:
+        if (sw_case)
+            sw_case[sw_ncase].val = Num_entry(Case_entry(a).next).val;
+        ++sw_ncase;
+        sw_scan((int*)Case_entry(a).expr);
+        break;
+    case Default:
+        sw_scan((int*)Double_entry(a).v1);
+        break;
+    } // the labels of a nested switch are its own
+}
+
+// index of the case label of value v
+static int sw_find(int v) {
+    int lo = 0, hi = sw_ncase - 1;
+    while (lo <= hi) {
+        int m = (lo + hi) / 2;
+        if (sw_case[m].val == v)
+            return m;
+        if (sw_case[m].val < v)
+            lo = m + 1;
+        else
+            hi = m - 1;
+    }
+    fatal("unexpected compiler error");
+}
+
+// compare the switch value in r0 with v
+static void sw_cmp(int v) {
+    if (v >= 0 && v < 256) {
+        emit(0x2800 | v); // cmp r0,#n
+        return;
+    }
+    emit_load_immediate(3, v);
+    emit(0x4298); // cmp r0,r3
+}
+
+// branch on condition cc to case label k, or to the default if k is -1
+static void sw_jump(int cc, int k) {
+    struct patch_s* p = cc_malloc(sizeof(struct patch_s), 1, 1);
+    if (cc != CC_AL)
+        emit(0xd001 | ((cc ^ 1) << 8)); // b<!cc> over the jump
+    p->addr = emit_call(0);
+    p->val = k;
+    p->next = sw_jmps;
+    sw_jmps = p;
+}
+
+// binary search of the case labels lo to hi - 1
+static void sw_search(int lo, int hi) {
+    while (hi - lo > SW_LINEAR) {
+        int m = (lo + hi) / 2;
+        sw_cmp(sw_case[m].val);
+        emit(0xd001 | ((CC_GT ^ 1) << 8)); // ble over the jump to the upper half
+        uint16_t* up = emit_call(0);       // before the beq, which may fold the cmp into cbz
+        sw_jump(CC_EQ, m);
+        sw_search(lo, m);
+        patch_branch(up, e + 1);
+        lo = m + 1;
+    }
+    for (; lo < hi; ++lo) {
+        sw_cmp(sw_case[lo].val);
+        sw_jump(CC_EQ, lo);
+    }
+    sw_jump(CC_AL, -1);
+}
+
+// jump table dispatch, the table is filled in once the case labels are placed
+static void sw_table(struct switch_s* sw) {
+    int lo = sw_case[0].val;
+    if (pcrel_1st && (int)e + 2 * sw->n + 16 + 4 * pcrel_count - (int)pcrel_1st >= 960)
+        patch_pc_relative(1);
+    if (lo > 0 && lo < 256)
+        emit(0x3800 | lo); // subs r0,#n
+    else if (lo < 0 && lo > -256)
+        emit(0x3000 | -lo); // adds r0,#n
+    else if (lo) {
+        emit_load_immediate(3, lo);
+        emit(0x1ac0); // subs r0,r0,r3
+    }
+    sw_cmp(sw->n - 1);
+    sw_jump(CC_HI, -1);
+#if PICO_RP2350
+    emit2(0xe8df, 0xf010); // tbh [pc,r0,lsl #1]
+#else
+    emit(0x0040); // lsls r0,r0,#1
+    emit(0x4478); // add r0,pc
+    emit(0x8840); // ldrh r0,[r0,#2]
+    emit(0x4487); // add pc,r0
+#endif
+    if (e + sw->n >= text_end - 1)
+        text_full();
+    sw->tab = e + 1;
+    memset(sw->tab, 0, sw->n * sizeof(*e)); // data, kept out of the peep hole's sight
+    e += sw->n;
+}
+
+// target of jump table entry k
+static uint16_t* sw_target(struct switch_s* sw, int k) {
+#if PICO_RP2350
+    return sw->tab + sw->tab[k];
+#else
+    return sw->tab + 1 + sw->tab[k] / 2;
+#endif
+}
+
+// point jump table entry k at to
+static void sw_entry(struct switch_s* sw, int k, uint16_t* to) {
+#if PICO_RP2350
+    int ofs = to - sw->tab; // halfwords from the table
+#else
+    int ofs = (to - (sw->tab + 1)) * 2; // bytes from the pc of add pc,r0
+#endif
+    if (ofs < 0 || ofs > 0xffff)
+        fatal("switch statement too big");
+    sw->tab[k] = ofs;
+}
+
+static void gen_switch(int* n) {
+    struct case_s* ocase = sw_case;
+    struct patch_s *obrks = brks, *ojmps = sw_jmps, *t;
+    uint16_t* odef = def;
+    int oncase = sw_ncase, i, j;
+    gen((int*)Switch_entry(n).cond); // value in r0
+    def = 0;
+    brks = sw_jmps = 0;
+    sw_case = 0;
+    sw_ncase = 0;
+    sw_scan((int*)Switch_entry(n).cas);
+    sw_case = cc_malloc((sw_ncase + 1) * sizeof(struct case_s), 1, 1);
+    sw_ncase = 0;
+    sw_scan((int*)Switch_entry(n).cas);
+    for (i = 1; i < sw_ncase; ++i) { // sort by value, mostly in order already
+        struct case_s c = sw_case[i];
+        for (j = i; j > 0 && sw_case[j - 1].val > c.val; --j)
+            sw_case[j] = sw_case[j - 1];
+        if (j > 0 && sw_case[j - 1].val == c.val)
+            fatal("duplicate case label %d", c.val);
+        sw_case[j] = c;
+    }
+    struct switch_s* sw = cc_malloc(sizeof(struct switch_s), 1, 1);
+    sw->next = sws;
+    sws = sw;
+    sw->addr = e + 1;
+    sw->cases = sw_ncase;
+    sw->line = Switch_entry(n).line;
+    unsigned span = sw_ncase ? (unsigned)sw_case[sw_ncase - 1].val - sw_case[0].val : 0;
+    if (sw_ncase >= SW_TABLE_MIN && span < SW_TABLE_MAX && span < SW_DENSITY * sw_ncase) {
+        sw->n = span + 1;
+        sw_table(sw);
+    } else
+        sw_search(0, sw_ncase);
+    gen((int*)Switch_entry(n).cas); // case statements
+    uint16_t* dflt = (def ? def : e) + 1;
+    for (; sw_jmps; sw_jmps = t) {
+        t = sw_jmps->next;
+        patch_branch(sw_jmps->addr, (sw_jmps->val < 0) ? dflt : sw_case[sw_jmps->val].addr);
+        cc_free(sw_jmps, 0);
+    }
+    for (i = j = 0; i < sw->n; ++i)
+        if (sw_case[j].val - sw_case[0].val == i)
+            sw_entry(sw, i, sw_case[j++].addr);
+        else
+            sw_entry(sw, i, dflt);
+    for (; brks; brks = t) {
+        t = brks->next;
+        patch_branch(brks->addr, e + 1);
+        cc_free(brks, 0);
+    }
+    cc_free(sw_case, 0);
+    sw_case = ocase;
+    sw_ncase = oncase;
+    sw_jmps = ojmps;
+    brks = obrks;
+    def = odef;
+}
+
+// annotate the listing at a with the dispatch of the switch statement starting there,
+// returns the size in halfwords of the jump table listed at a
+static int sw_list(uint16_t* a) {
+    for (struct switch_s* sw = sws; sw; sw = sw->next) {
+        if (a == sw->addr) {
+            if (sw->tab)
+                printf("; switch line %d: jump table, %d cases in %d entries\n", sw->line,
+                       sw->cases, sw->n);
+            else
+                printf("; switch line %d: binary search, %d cases\n", sw->line, sw->cases);
+        }
+        if (a == sw->tab) {
+            for (int k = 0; k < sw->n; ++k)
+                printf("%08x    %04x        .hword  0x%04x  ; -> %08x\n", (int)(sw->tab + k),
+                       sw->tab[k], sw->tab[k], (int)sw_target(sw, k));
+            return sw->n;
+        }
+    }
+    return 0;
+}
+
+// the switch statements of the function just generated
+static void sw_free(void) {
+    while (sws) {
+        struct switch_s* sw = sws->next;
+        cc_free(sws, 0);
+        sws = sw;
+    }
 }
 
 // AST parsing for Thumb code generatiion
 
 static void gen(int* n) {
-    int i = ast_Tk(n), j, k, l;
+    int i = ast_Tk(n), j, k, l, h;
     uint16_t *a, *b, *c, *d, *t;
     struct ident_s* label;
     struct patch_s* patch;
@@ -2910,9 +5290,36 @@ static void gen(int* n) {
     switch (i) {
     case Num:
     case NumF:
+        if (i == Num && Num_entry(n).seg && seg_addr(Num_entry(n).val)) { // relocated address
+#if PICO_RP2350
+            if (gb_reg && (k = gb_ofs(Num_entry(n).val, gb_base, CHAR)) >= 0) {
+                emit2(0xf200 | ((k >> 1) & 0x400) | gb_reg,
+                      ((k << 4) & 0x7000) | (k & 0xff)); // addw r0,rb,#n
+                break;
+            }
+#endif
+            emit_load_long_imm(0, Num_entry(n).val, 1);
+            break;
+        }
         emit_load_immediate(0, Num_entry(n).val);
         break; // int or float value
+    case Id:
+        emit_load_long_imm(0, ((struct ident_s*)Double_entry(n).v1)->val | 1, 1);
+        break; // function address
     case Load:
+        if ((k = rv_find(n + Load_words)) ||
+            (ast_Tk(n + Load_words) == ';' && (k = rv_cmpd))) { // register variable
+            emit_mov(0, k);
+            break;
+        }
+        if (var_reach((ast_Tk(n + Load_words) == ';') ? var_cmpd : n + Load_words,
+                      Num_entry(n).val)) { // global or frame variable
+            emit_var((ast_Tk(n + Load_words) == ';') ? var_cmpd : n + Load_words,
+                     Num_entry(n).val, 0);
+            break;
+        }
+        if (gen_load_index(n))
+            break;
         gen(n + Load_words);                                        // load the value
         if (Num_entry(n).val > ATOM_TYPE && Num_entry(n).val < PTR) // unreachable?
             fatal("struct copies not yet supported");
@@ -2922,13 +5329,47 @@ static void gen(int* n) {
         emit_load_addr(Num_entry(n).val);
         break; // get address of variable
     case '{':
+        if (gen_divmod(n))
+            break;
         gen(Begin_entry(n).next);
         gen(n + Begin_words);
-        break;   // parse AST expr or stmt
+        break; // parse AST expr or stmt
+    case '(':
+        gen((int*)Double_entry(n).v1);
+        break;   // shared or rewritten expression
     case Assign: // assign the value to variables
-        gen((int*)Assign_entry(n).right_part);
-        emit_push(0);
+        h = 0;
+        int* vt = 0;
+        k = rv_find((int*)Assign_entry(n).right_part);
+        if (!k && var_reach((int*)Assign_entry(n).right_part, Num_entry(n).val & 0xffff))
+            vt = (int*)Assign_entry(n).right_part; // stored directly
+        if (!k && !vt) {
+            gen((int*)Assign_entry(n).right_part);
+            j = 1;
+            if (rs_need(n, &j) <= RS_SLOTS - rs_depth) { // hold the address in a register
+                h = ++rs_depth;
+                emit_mov(h, 0);
+            } else
+                emit_push(0);
+        }
+        int *v = n + Assign_words, *vl = (int*)Oper_entry(v).oprnd, *vr = v + Oper_words;
+        if (k && Num_entry(n).val == ((INT << 16) | INT) && (ast_Tk(v) == Add || ast_Tk(v) == Sub) &&
+            ast_Tk(vl) == Load &&
+            (ast_Tk(vl + Load_words) == ';' || rv_find(vl + Load_words) == k) &&
+            ast_Tk(vr) == Num && Num_entry(vr).val >= 0 && Num_entry(vr).val < 256) {
+            // register plus small constant
+            emit_add_imm(k, (ast_Tk(v) == Add) ? Num_entry(vr).val : -Num_entry(vr).val);
+            break;
+        }
+        j = rv_cmpd; // compound assignment loads its target from here
+        int* vj = var_cmpd;
+        rv_cmpd = k;
+        var_cmpd = vt;
         gen(n + Assign_words); // xxxx
+        rv_cmpd = j;
+        var_cmpd = vj;
+        if (h)
+            --rs_depth;
         l = Num_entry(n).val & 0xffff;
         // Add SC/SI instruction to save value in register to variable address
         // held on stack.
@@ -2938,27 +5379,67 @@ static void gen(int* n) {
             emit_cast(FTOI);
         else if ((Num_entry(n).val >> 16) == INT && l == FLOAT)
             emit_cast(ITOF);
-        emit_store((l >= PTR) ? SI : SC + (l >> 2));
+        if (k)
+            emit_mov(k, 0);
+        else if (vt)
+            emit_var(vt, l, 1);
+        else if (h)
+            emit_store_reg((l >= PTR) ? SI : SC + (l >> 2), h);
+        else
+            emit_store((l >= PTR) ? SI : SC + (l >> 2));
         break;
     case Inc: // increment or decrement variables
     case Dec:
+        l = (Num_entry(n).val >= PTR2)
+                ? sizeof(int)
+                : ((Num_entry(n).val >= PTR) ? tsize[(Num_entry(n).val - PTR) >> 2] : 1);
+        if ((k = rv_find(n + Oper_words))) {
+            if (l < 256)
+                emit_add_imm(k, (i == Inc) ? l : -l);
+            else {
+                emit_mov(0, k);
+                emit_push(0);
+                emit_load_immediate(0, l);
+                emit_oper((i == Inc) ? ADD : SUB);
+                emit_mov(k, 0);
+            }
+            break;
+        }
+        if (l < 256 && var_reach(n + Oper_words, (Num_entry(n).val == CHAR) ? CHAR : INT)) {
+            emit_var(n + Oper_words, (Num_entry(n).val == CHAR) ? CHAR : INT, 0);
+            emit(((i == Inc) ? 0x3000 : 0x3800) | l); // adds/subs r0,#n
+            emit_var(n + Oper_words, (Num_entry(n).val == CHAR) ? CHAR : INT, 1);
+            break;
+        }
         gen(n + Oper_words);
+        if (rs_depth < RS_SLOTS) { // hold the address in a register
+            k = rs_depth + 1;
+            emit_mov(k, 0);
+            emit_load((Num_entry(n).val == CHAR) ? LC : LI);
+            if (l < 256)
+                emit(((i == Inc) ? 0x3000 : 0x3800) | l); // adds/subs r0,#n
+            else {
+                emit_load_immediate(3, l);
+                emit((i == Inc) ? 0x18c0 : 0x1ac0); // adds/subs r0,r0,r3
+            }
+            emit_store_reg((Num_entry(n).val == CHAR) ? SC : SI, k);
+            break;
+        }
         emit_push(0);
         emit_load((Num_entry(n).val == CHAR) ? LC : LI);
         emit_push(0);
-        emit_load_immediate(
-            0, (Num_entry(n).val >= PTR2)
-                   ? sizeof(int)
-                   : ((Num_entry(n).val >= PTR) ? tsize[(Num_entry(n).val - PTR) >> 2] : 1));
+        emit_load_immediate(0, l);
         emit_oper((i == Inc) ? ADD : SUB);
         emit_store((Num_entry(n).val == CHAR) ? SC : SI);
         break;
-    case Cond:                              // if else condition case
-        gen((int*)Cond_entry(n).cond_part); // condition
-        // Add jump-if-zero instruction "BZ" to jump to false branch.
+    case Cond: // if else condition case
+#if PICO_RP2350
+        if (gen_it(n))
+            break;
+#endif
+        // Branch over the jump to the false branch when the condition holds.
         // Point "b" to the jump address field to be patched later.
-        emit(0x2800); // cmp r0,#0
-        emit_cond_branch(e + 2, BNZ);
+        emit_cond_branch(e + 2, gen_cond((int*)Cond_entry(n).cond_part));
         b = emit_call(0);
         gen((int*)Cond_entry(n).if_part); // expression
         // Patch the jump address field pointed to by "b" to hold the address
@@ -2986,7 +5467,7 @@ static void gen(int* n) {
     case Lor:
         gen((int*)Num_entry(n).val);
         emit(0x2800); // cmp r0,#0
-        emit_cond_branch(e + 2, BZ);
+        emit_cond_branch(e + 2, CC_EQ);
         b = emit_call(0);
         gen(n + Oper_words);
         patch_branch(b, e + 1);
@@ -2994,171 +5475,100 @@ static void gen(int* n) {
     case Lan:
         gen((int*)Num_entry(n).val);
         emit(0x2800); // cmp r0,#0
-        emit_cond_branch(e + 2, BNZ);
+        emit_cond_branch(e + 2, CC_NE);
         b = emit_call(0);
         gen(n + Oper_words);
         patch_branch(b, e + 1);
         break;
     /* If current token is bitwise OR operator:
-     * Add "PSH" instruction to push LHS value in register to stack.
-     * Parse RHS expression.
+     * Evaluate both operands, holding the first in r1/r2 or on the stack.
      * Add "OR" instruction to compute the result.
      */
     case Or:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(OR);
+        gen_oper(n, OR, 0);
         break;
     case Xor:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(XOR);
+        gen_oper(n, XOR, 0);
         break;
     case And:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(AND);
+        gen_oper(n, AND, 0);
         break;
     case Eq:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(EQ);
+        gen_oper(n, EQ, 0);
         break;
     case Ne:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(NE);
+        gen_oper(n, NE, 0);
         break;
     case Ge:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(GE);
+        gen_oper(n, GE, 0);
         break;
     case Lt:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(LT);
+        gen_oper(n, LT, 0);
         break;
     case Gt:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(GT);
+        gen_oper(n, GT, 0);
         break;
     case Le:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(LE);
+        gen_oper(n, LE, 0);
         break;
     case Shl:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(SHL);
+        gen_oper(n, SHL, 0);
         break;
     case Shr:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(SHR);
+        gen_oper(n, SHR, 0);
         break;
     case Add:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(ADD);
+#if PICO_RP2350
+        if (gen_mla(n))
+            break;
+#endif
+        gen_oper(n, ADD, 0);
         break;
     case Sub:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(SUB);
+        gen_oper(n, SUB, 0);
         break;
     case Mul:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(MUL);
+        gen_oper(n, MUL, 0);
         break;
     case Div:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(DIV);
-        break;
     case Mod:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_oper(MOD);
+        if ((k = div_const(n))) { // by a constant
+            if (rs_depth >= RS_SLOTS)
+                fatal("unexpected compiler error");
+            gen((int*)Oper_entry(n).oprnd);
+            emit_div_const(k, rs_depth + 1, i == Div, i == Mod);
+        } else
+            gen_oper(n, (i == Div) ? DIV : MOD, 0);
         break;
     case AddF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(ADDF);
+        gen_oper(n, ADDF, 1);
         break;
     case SubF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(SUBF);
+        gen_oper(n, SUBF, 1);
         break;
     case MulF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(MULF);
+        gen_oper(n, MULF, 1);
         break;
     case DivF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(DIVF);
+        gen_oper(n, DIVF, 1);
         break;
     case EqF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(EQF);
+        gen_oper(n, EQF, 1);
         break;
     case NeF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(NEF);
+        gen_oper(n, NEF, 1);
         break;
     case GeF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(GEF);
+        gen_oper(n, GEF, 1);
         break;
     case LtF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(LTF);
+        gen_oper(n, LTF, 1);
         break;
     case GtF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(GTF);
+        gen_oper(n, GTF, 1);
         break;
     case LeF:
-        gen((int*)Num_entry(n).val);
-        emit_push(0);
-        gen(n + Oper_words);
-        emit_float_oper(LEF);
+        gen_oper(n, LEF, 1);
         break;
     case CastF:
         gen((int*)CastF_entry(n).val);
@@ -3190,13 +5600,16 @@ static void gen(int* n) {
         if (i == Syscall)
             emit_syscall(Func_entry(n).addr, Func_entry(n).parm_types);
         else if (i == Func) {
-            emit_call(Func_entry(n).addr);
+            ++fp_calls;
+            emit_call(((struct ident_s*)Func_entry(n).addr)->val);
             emit_adjust_stack(Func_entry(n).n_parms);
         }
         break;
     case While:
     case DoWhile:
-        if (i == While)
+        // -1 for a run time condition, else the value of the constant condition
+        h = (ast_Tk(While_entry(n).cond) == Num) ? Num_entry(While_entry(n).cond).val != 0 : -1;
+        if (i == While && h != 1)
             a = emit_call(0);
         b = (uint16_t*)brks;
         brks = 0;
@@ -3204,7 +5617,7 @@ static void gen(int* n) {
         cnts = 0;
         d = e;
         gen((int*)While_entry(n).body); // loop body
-        if (i == While)
+        if (i == While && h != 1)
             patch_branch(a, e + 1);
         while (cnts) {
             t = (uint16_t*)cnts->next;
@@ -3213,9 +5626,12 @@ static void gen(int* n) {
             cnts = (struct patch_s*)t;
         }
         cnts = (struct patch_s*)c;
-        gen((int*)While_entry(n).cond); // condition
-        emit(0x2800);                   // cmp r0,#0
-        emit_cond_branch(d - 1, BNZ);
+        if (h < 0) {
+            emit_cond_branch(d - 1, gen_cond((int*)While_entry(n).cond)); // condition
+        } else if (h) {
+            emit_branch(d - 1);
+            pool_barrier();
+        }
         while (brks) {
             t = (uint16_t*)brks->next;
             patch_branch(brks->addr, e + 1);
@@ -3243,12 +5659,12 @@ static void gen(int* n) {
         cnts = (struct patch_s*)c;
         gen((int*)For_entry(n).incr); // increment
         patch_branch(a, e + 1);
-        if (For_entry(n).cond) {
-            gen((int*)For_entry(n).cond); // condition
-            emit(0x2800);                 // cmp r0,#0
-            emit_cond_branch(a, BNZ);
-        } else
+        if (For_entry(n).cond && ast_Tk(For_entry(n).cond) != Num) {
+            emit_cond_branch(a, gen_cond((int*)For_entry(n).cond)); // condition
+        } else if (!For_entry(n).cond || Num_entry(For_entry(n).cond).val) {
             emit_branch(a);
+            pool_barrier();
+        }
         while (brks) {
             t = (uint16_t*)brks->next;
             patch_branch(brks->addr, e + 1);
@@ -3258,54 +5674,25 @@ static void gen(int* n) {
         brks = (struct patch_s*)b;
         break;
     case Switch:
-        gen((int*)Switch_entry(n).cond); // condition
-        emit_push(0);
-        a = ecas;
-        ecas = emit_call(0);
-        b = (uint16_t*)brks;
-        d = def;
-        def = 0;
-        brks = 0;
-        gen((int*)Switch_entry(n).cas); // case statment
-        // deal with no default inside switch case
-        patch_branch(ecas, (def ? def : e) + 1);
-        while (brks) {
-            t = (uint16_t*)brks->next;
-            patch_branch((uint16_t*)(brks->addr), e + 1);
-            cc_free(brks, 0);
-            brks = (struct patch_s*)t;
-        }
-        emit_adjust_stack(1);
-        brks = (struct patch_s*)b;
-        def = d;
+        gen_switch(n);
         break;
     case Case:
-        a = 0;
-        patch_branch(ecas, e + 1);
-        gen((int*)Num_entry(n).val); // condition
-        // if (*(e - 1) != IMM) // ***FIX***
-        //    fatal("case label not a numeric literal");
-        emit(0x9b00); // ldr r3, [sp, #0]
-        emit(0x4298); // cmp r0, r3
-        emit_cond_branch(e + 2, BZ);
-        ecas = emit_call(0);
-        if (*((int*)Case_entry(n).expr) == Switch)
-            a = ecas;
-        gen((int*)Case_entry(n).expr); // expression
-        if (a != 0)
-            ecas = a;
+        sw_case[sw_find(Num_entry(Case_entry(n).next).val)].addr = e + 1;
+        gen((int*)Case_entry(n).expr); // statement
         break;
     case Break:
         patch = cc_malloc(sizeof(struct patch_s), 1, 1);
         patch->addr = emit_call(0);
         patch->next = brks;
         brks = patch;
+        pool_barrier();
         break;
     case Continue:
         patch = cc_malloc(sizeof(struct patch_s), 1, 1);
         patch->next = cnts;
         patch->addr = emit_call(0);
         cnts = patch;
+        pool_barrier();
         break;
     case Goto:
         label = (struct ident_s*)Num_entry(n).val;
@@ -3316,6 +5703,7 @@ static void gen(int* n) {
             label->forward = (uint16_t*)l;
         } else
             emit_branch((uint16_t*)label->val - 1);
+        pool_barrier();
         break;
     case Default:
         def = e;
@@ -3325,11 +5713,14 @@ static void gen(int* n) {
         if (Num_entry(n).val)
             gen((int*)Num_entry(n).val);
         emit_leave();
+        pool_barrier();
         break;
     case Enter:
         emit_enter(Num_entry(n).val);
         gen(n + Enter_words);
         emit_leave();
+        if (fp_leaf && fp_calls)
+            fatal("unexpected compiler error");
         patch_pc_relative(0);
         break;
     case Label: // target of goto
@@ -3343,13 +5734,569 @@ static void gen(int* n) {
             label->forward = (uint16_t*)l->next;
             cc_free(l, 0);
         }
-        label->val = (int)d;
-        label->class = Label;
-        break;
-    default:
-        if (i != ';')
-            fatal("%d: compiler error gen=%08x\n", lineno, i);
+        label->val = (int)d;
+        label->class = Label;
+        break;
+    default:
+        if (i != ';')
+            fatal("%d: compiler error gen=%08x\n", lineno, i);
+    }
+}
+
+// Function post pass. The finished code of a function is decoded into one entry per
+// halfword and its branches are rewritten. Jumps to a jump go to the final target, a
+// conditional branch over a jump becomes the inverted branch, branches to the next
+// instruction, code nothing reaches after a jump or return, a reload of a register variable
+// just stored and a move into r0 overwritten at once are dropped. The code is then laid
+// out again, relaxing every branch to the shortest encoding that reaches once the final
+// distances are known, with the literal pools realigned and their relocations following.
+// CM0+ branches are B.N and B<c>, else BL or an inverted B<c> over B.N. CM33 branches
+// also fold a cmp rn,#0 into CBZ/CBNZ and grow to B.W and B<c>.W, which keep lr. A CM33
+// literal loaded once is loaded by ldr.w from the pool of an earlier function holding it.
+
+#define P_INS 0x01  // instruction start
+#define P_WORD 0x02 // literal pool word start
+#define P_DEL 0x04  // removed
+#define P_TGT 0x08  // branch target
+#define P_IT 0x10   // inside an IT block, left alone
+#define P_USED 0x20 // literal word still loaded
+#define P_PAD 0x40  // literal word preceded by an alignment nop
+#define P_TAB 0x80  // switch jump table entry
+
+enum { K_OP, K_JMP, K_JCC, K_CALL, K_LIT, K_VLIT, K_LITW, K_RET };
+
+struct post_s {
+    int16_t tg; // branch or jump table target or literal word, old halfword index
+    int16_t at; // halfword index in the new layout
+    uint8_t fl; // P_ flags
+    uint8_t kd; // K_ kind
+    uint8_t sz; // old size in halfwords
+    uint8_t ns; // new size in halfwords
+    uint8_t cc; // condition of a conditional branch, loads of a literal word
+    uint8_t rz; // 1 + register a folded cmp rn,#0 tests, CM33
+};
+
+static struct post_s* post UDATA; // one entry per halfword of the function
+static uint16_t* post_code UDATA; // copy of the function code
+static int post_n UDATA;          // function size in halfwords
+static int post_saved UDATA;      // bytes removed, all functions
+
+#if PICO_RP2350
+#define POOL_SEEN 64 // literal words of the earlier functions open to ldr.w, a power of 2
+
+static struct {
+    int addr; // word address
+    int val;  // word value
+    int ext;  // !0 -> relocated
+} pool_seen[POOL_SEEN] UDATA;
+static int pool_nseen UDATA; // words seen, the oldest overwritten
+#endif
+
+// next kept instruction at or after i, stepping over literal words if skip is set
+static int post_live(int i, int skip) {
+    int m = skip ? P_INS : P_INS | P_WORD | P_TAB;
+    while (i < post_n && ((post[i].fl & P_DEL) || !(post[i].fl & m)))
+        ++i;
+    return i;
+}
+
+static void post_target(int i) { post[post_live(i, 1)].fl |= P_TGT; }
+
+// remove the entry at i, the branches to it now reach the next instruction
+static void post_del(int i) {
+    post[i].fl |= P_DEL;
+    if (post[i].fl & P_TGT)
+        post_target(i + post[i].sz);
+}
+
+static void post_decode(int addr) {
+    int it = 0;
+    for (int i = 0; i < post_n; i += post[i].sz) {
+        struct post_s* q = post + i;
+        uint16_t h = post_code[i];
+        if (q->fl & (P_WORD | P_TAB)) {
+            q->sz = (q->fl & P_WORD) ? 2 : 1;
+            continue;
+        }
+        q->fl |= P_INS | (it ? P_IT : 0);
+        if (it)
+            --it;
+        q->sz = ((h >> 11) >= 0x1d) ? 2 : 1;
+        if ((h & 0xf800) == 0xe000) { // b.n
+            q->kd = K_JMP;
+            q->tg = i + 2 + ((int)((uint32_t)h << 21) >> 21);
+        } else if ((h & 0xf000) == 0xd000 && ((h >> 8) & 0xf) < 14) { // bcc
+            q->kd = K_JCC;
+            q->cc = (h >> 8) & 0xf;
+            q->tg = i + 2 + (int8_t)h;
+        } else if ((h & 0xf800) == 0xf000 && (post_code[i + 1] & 0xd000) == 0xd000) { // bl
+            int t = (bl_target(addr + i * 2, h, post_code[i + 1]) - addr) / 2;
+            q->kd = (t > 0 && t < post_n) ? K_JMP : K_CALL;
+            q->tg = t;
+        } else if ((h & 0xf800) == 0x4800 || (h & 0xffbf) == 0xed9f) { // ldr/vldr [pc,#n]
+            q->kd = ((h & 0xf800) == 0x4800) ? K_LIT : K_VLIT;
+            int ofs = (q->kd == K_LIT) ? h & 0xff : post_code[i + 1] & 0xff;
+            q->tg = ((((addr + i * 2 + 4) & ~3) + ofs * 4) - addr) / 2;
+            if (q->tg >= post_n - 1)
+                fatal("unexpected compiler error");
+            post[q->tg].fl |= P_WORD;
+        } else if ((h & 0xff00) == 0xbd00 || h == 0x4760) // pop {..,pc}, bx ip
+            q->kd = K_RET;
+        else if ((h & 0xff00) == 0xbf00 && (h & 0xf))
+            it = 4 - __builtin_ctz(h & 0xf);
+        else if ((h == 0x46c0 || h == 0xbf00) && !(q->fl & P_IT)) // the layout pads again
+            q->fl |= P_DEL;
+    }
+}
+
+// one round of rewriting, returns the number of changes
+static int post_round(void) {
+    int i, j, t, k = 0;
+    for (i = 0; i < post_n; i += post[i].sz)
+        post[i].fl &= ~P_TGT;
+    for (i = 0; i < post_n; i += post[i].sz)
+        if ((post[i].fl & (P_INS | P_DEL)) == P_INS &&
+            (post[i].kd == K_JMP || post[i].kd == K_JCC))
+            post_target(post[i].tg);
+        else if (post[i].fl & P_TAB)
+            post_target(post[i].tg);
+    for (i = post_live(0, 0); i < post_n; i = post_live(i + post[i].sz, 0)) {
+        struct post_s* q = post + i;
+        if (q->fl & (P_WORD | P_IT | P_TAB))
+            continue;
+        j = post_live(i + q->sz, 0);
+        if (q->kd == K_JMP || q->kd == K_JCC) {
+            for (int h = 0; h < 8; ++h) { // jump to jump
+                t = post_live(q->tg, 1);
+                if (t >= post_n || post[t].kd != K_JMP || (post[t].fl & P_IT) ||
+                    post_live(post[t].tg, 1) == t || post[t].tg == q->tg)
+                    break;
+                q->tg = post[t].tg;
+                post_target(q->tg);
+                ++k;
+            }
+            if (q->kd == K_JCC && j < post_n && post[j].kd == K_JMP &&
+                !(post[j].fl & (P_WORD | P_IT | P_TGT)) &&
+                post_live(q->tg, 1) == post_live(j + post[j].sz, 0)) { // bcc over a jump
+                q->cc ^= 1;
+                q->tg = post[j].tg;
+                post_del(j);
+                j = post_live(i + q->sz, 0);
+                ++k;
+            }
+            if (post_live(q->tg, 1) == j) { // branch to the next instruction
+                post_del(i);
+                ++k;
+                continue;
+            }
+        }
+        if (q->kd == K_JMP || q->kd == K_RET) { // nothing reaches the code that follows
+            for (t = post_live(i + q->sz, 1); t < post_n && !(post[t].fl & P_TGT);
+                 t = post_live(t + post[t].sz, 1)) {
+                post_del(t);
+                ++k;
+            }
+            continue;
+        }
+        if (j >= post_n || (post[j].fl & (P_WORD | P_IT | P_TAB)))
+            continue;
+        uint16_t h = post_code[i], h2 = post_code[j];
+        int x = ((h >> 4) & 8) | (h & 7);
+        if ((h & 0xff78) == 0x4600 && x && x < 13 && h2 == (0x4600 | (x << 3)) &&
+            !(post[j].fl & P_TGT)) { // mov rx,r0 then mov r0,rx
+            post_del(j);
+            ++k;
+        } else if ((h & 0xff87) == 0x4600 && (h & 0x78) &&
+                   ((h2 & 0xff00) == 0x2000 || (h2 & 0xff00) == 0x4800 ||
+                    ((h2 & 0xff87) == 0x4600 && (h2 & 0x78)))) { // mov r0,ry overwritten
+            post_del(i);
+            ++k;
+        }
+    }
+    return k;
+}
+
+// does the branch at q reach ofs halfwords past its pc at its current size
+static int post_fits(struct post_s* q, int ofs) {
+    if (q->kd == K_JMP) // b.n, else bl or b.w
+        return q->ns > 1 || (ofs >= -1024 && ofs < 1024);
+#if PICO_RP2350
+    if (q->rz) { // cbz/cbnz, else cmp rn,#0 before b<c> or b<c>.w
+        if (q->ns == 1)
+            return ofs >= 0 && ofs < 64;
+        return q->ns > 2 || (ofs - 1 >= -128 && ofs - 1 < 128);
+    }
+    return q->ns > 1 || (ofs >= -128 && ofs < 128); // b<c>, else b<c>.w
+#else
+    if (q->ns == 1) // b<c>, else an inverted b<c> over b.n or bl
+        return ofs >= -128 && ofs < 128;
+    return q->ns > 2 || (ofs - 1 >= -1024 && ofs - 1 < 1024);
+#endif
+}
+
+// new halfword index of every kept entry, growing the branches out of range, returns the size
+static int post_layout(int addr) {
+    int i, pos, grown = 1;
+    while (grown) {
+        grown = 0;
+        pos = 0;
+        for (i = 0; i < post_n; i += post[i].sz) {
+            struct post_s* q = post + i;
+            if (q->fl & P_DEL)
+                continue;
+            q->fl &= ~P_PAD;
+            if ((q->fl & P_WORD) && ((addr + pos * 2) & 2)) {
+                q->fl |= P_PAD;
+                ++pos;
+            }
+            q->at = pos;
+            pos += q->ns;
+        }
+        for (i = 0; i < post_n; i += post[i].sz) {
+            struct post_s* q = post + i;
+            if ((q->fl & (P_DEL | P_WORD)) || (q->kd != K_JMP && q->kd != K_JCC))
+                continue;
+            int t = post_live(q->tg, 1);
+            if (t >= post_n)
+                fatal("unexpected compiler error");
+            if (!post_fits(q, post[t].at - (q->at + 2))) {
+                ++q->ns;
+                grown = 1;
+            }
+        }
+    }
+    return pos;
+}
+
+static void post_write(uint16_t* start) {
+    int addr = (int)start;
+    for (int i = 0; i < post_n; i += post[i].sz) {
+        struct post_s* q = post + i;
+        if (q->fl & P_DEL)
+            continue;
+        uint16_t *d = start + q->at, *c = post_code + i;
+        uint32_t bl;
+        int t = 0, ofs = 0;
+        if (q->kd == K_JMP || q->kd == K_JCC) {
+            t = addr + post[post_live(q->tg, 1)].at * 2;
+            ofs = (t - ((int)d + 4)) / 2;
+        }
+        if (q->fl & P_PAD)
+#if PICO_RP2350
+            d[-1] = 0xbf00; // nop
+#else
+            d[-1] = 0x46c0; // mov r8,r8
+#endif
+        if (q->fl & P_WORD) {
+            d[0] = c[0];
+            d[1] = c[1];
+            continue;
+        }
+        switch (q->kd) {
+        case K_JMP:
+            if (q->ns == 1) {
+                d[0] = 0xe000 | (ofs & 0x7ff); // b.n
+                break;
+            }
+            bl = bl_code((int)d, t);
+#if PICO_RP2350
+            bl &= ~0x4000; // b.w
+#endif
+            d[0] = bl >> 16;
+            d[1] = bl;
+            break;
+        case K_JCC:
+#if PICO_RP2350
+            if (q->rz) {
+                if (q->ns == 1) { // cbz/cbnz
+                    d[0] = (q->cc ? 0xb900 : 0xb100) | ((ofs >> 5) << 9) | ((ofs & 0x1f) << 3) |
+                           (q->rz - 1);
+                    break;
+                }
+                *d++ = 0x2800 | ((q->rz - 1) << 8); // cmp rn,#0
+                --ofs;
+            }
+            if (q->ns == 1 + (q->rz != 0)) {
+                d[0] = 0xd000 | (q->cc << 8) | (ofs & 0xff); // b<c>
+                break;
+            }
+            d[0] = 0xf000 | (((ofs >> 19) & 1) << 10) | (q->cc << 6) | ((ofs >> 11) & 0x3f);
+            d[1] = 0x8000 | (((ofs >> 17) & 1) << 13) | (((ofs >> 18) & 1) << 11) |
+                   (ofs & 0x7ff); // b<c>.w
+#else
+            if (q->ns == 1) {
+                d[0] = 0xd000 | (q->cc << 8) | (ofs & 0xff); // b<c>
+                break;
+            }
+            d[0] = 0xd000 | ((q->cc ^ 1) << 8) | (q->ns - 2); // inverted b<c> over the jump
+            if (q->ns == 2) {
+                d[1] = 0xe000 | ((ofs - 1) & 0x7ff); // b.n
+                break;
+            }
+            bl = bl_code((int)(d + 1), t);
+            d[1] = bl >> 16;
+            d[2] = bl;
+#endif
+            break;
+        case K_CALL:
+            bl = bl_code((int)d, bl_target(addr + i * 2, c[0], c[1]));
+            d[0] = bl >> 16;
+            d[1] = bl;
+            break;
+#if PICO_RP2350
+        case K_LITW:
+            ofs = (((int)d + 4) & ~3) - pool_seen[q->tg].addr;
+            if (ofs <= 0 || ofs > 4095)
+                fatal("unexpected compiler error");
+            d[0] = 0xf85f; // ldr.w rt,[pc,#-n]
+            d[1] = (((c[0] >> 8) & 7) << 12) | ofs;
+            break;
+#endif
+        case K_LIT:
+        case K_VLIT:
+            ofs = ((addr + post[q->tg].at * 2) - (((int)d + 4) & ~3)) / 4;
+            if (ofs < 0 || ofs > 255)
+                fatal("unexpected compiler error");
+            d[0] = (q->kd == K_LIT) ? (c[0] & 0xff00) | ofs : c[0];
+            if (q->kd == K_VLIT)
+                d[1] = (c[1] & 0xff00) | ofs;
+            break;
+        default:
+            d[0] = c[0];
+            if (q->sz == 2)
+                d[1] = c[1];
+        }
+    }
+}
+
+#if PICO_RP2350
+// is the word at a relocated
+static int post_ext(int a) {
+    for (struct reloc_s* r = relocs; r; r = r->next)
+        if (r->addr == a)
+            return 1;
+    return 0;
+}
+
+// load the literals loaded once from an earlier function's pool instead, where ldr.w reaches
+static void post_reuse(int addr) {
+    int n = 0; // each ldr.w grows the code after it by a halfword
+    for (int i = 0; i < post_n; i += post[i].sz) {
+        struct post_s* q = post + i;
+        if ((q->fl & (P_INS | P_DEL)) != P_INS || q->kd != K_LIT || post[q->tg].cc != 1)
+            continue;
+        int val = post_code[q->tg] | (post_code[q->tg + 1] << 16), ext = post_ext(addr + q->tg * 2);
+        int pc = ((addr + i * 2 + 4) & ~3) + n * 2;
+        for (int k = 0; k < POOL_SEEN && k < pool_nseen; ++k)
+            if (pool_seen[k].val == val && pool_seen[k].ext == ext && pool_seen[k].addr < addr &&
+                pc - pool_seen[k].addr <= 4095 && *(int*)pool_seen[k].addr == val) {
+                post[q->tg].fl |= P_DEL;
+                q->kd = K_LITW;
+                q->tg = k;
+                q->ns = 2;
+                ++pool_reuse;
+                ++n;
+                break;
+            }
+    }
+}
+
+// remember the literal words of the function laid out from addr
+static void post_seen(int addr) {
+    for (int i = 0; i < post_n; i += post[i].sz)
+        if ((post[i].fl & (P_WORD | P_DEL)) == P_WORD) {
+            int k = pool_nseen++ & (POOL_SEEN - 1);
+            pool_seen[k].addr = addr + post[i].at * 2;
+            pool_seen[k].val = post_code[i] | (post_code[i + 1] << 16);
+            pool_seen[k].ext = post_ext(pool_seen[k].addr);
+        }
+}
+#endif
+
+// optimize the function from start to e
+static void post_func(uint16_t* start) {
+    int i, n, addr = (int)start;
+    post_n = (e + 1) - start;
+    post = cc_malloc((post_n + 1) * sizeof(struct post_s), 1, 1);
+    post_code = cc_malloc((post_n + 1) * sizeof(uint16_t), 1, 1);
+    memcpy(post_code, start, post_n * sizeof(uint16_t));
+    for (struct switch_s* sw = sws; sw; sw = sw->next)
+        for (i = 0; i < sw->n; ++i) {
+            post[sw->tab - start + i].fl = P_TAB;
+            post[sw->tab - start + i].tg = sw_target(sw, i) - start;
+        }
+    post_decode(addr);
+    for (i = 0; i < 8 && post_round(); ++i)
+        ;
+    // literal words no longer loaded
+    for (i = 0; i < post_n; i += post[i].sz)
+        if ((post[i].fl & (P_INS | P_DEL)) == P_INS &&
+            (post[i].kd == K_LIT || post[i].kd == K_VLIT)) {
+            post[post[i].tg].fl |= P_USED;
+            ++post[post[i].tg].cc;
+        }
+    for (i = 0; i < post_n; i += post[i].sz) {
+        post[i].ns = (post[i].kd == K_JMP || post[i].kd == K_JCC) ? 1 : post[i].sz;
+        if ((post[i].fl & (P_WORD | P_USED)) == P_WORD)
+            post[i].fl |= P_DEL;
+    }
+#if PICO_RP2350
+    post_reuse(addr);
+    // cmp rn,#0 then beq/bne, taken into the branch for cbz/cbnz
+    int j;
+    for (i = post_live(0, 0), j = -1; i < post_n; j = i, i = post_live(i + post[i].sz, 0))
+        if (j >= 0 && post[i].kd == K_JCC && post[i].cc < 2 &&
+            !(post[i].fl & (P_WORD | P_IT | P_TGT)) && (post_code[j] & 0xf8ff) == 0x2800 &&
+            !(post[j].fl & (P_WORD | P_IT | P_TGT | P_TAB))) {
+            post[i].rz = 1 + ((post_code[j] >> 8) & 7);
+            post[j].fl |= P_DEL;
+        }
+#endif
+    n = post_layout(addr);
+    if (start + n > text_end)
+        text_full();
+    post_write(start);
+    // the jump tables, and the switch statements moved for the listing
+    for (struct switch_s* sw = sws; sw; sw = sw->next) {
+        sw->addr = start + post[post_live(sw->addr - start, 1)].at;
+        if (!sw->tab)
+            continue;
+        i = sw->tab - start;
+        sw->tab = start + post[i].at;
+        for (int k = 0; k < sw->n; ++k)
+            sw_entry(sw, k, start + post[post_live(post[i + k].tg, 1)].at);
+    }
+    // the relocations of the literal words
+    for (struct reloc_s** rp = &relocs; *rp;) {
+        struct reloc_s* r = *rp;
+        i = (r->addr - addr) / 2;
+        if (r->addr >= addr && i < post_n) {
+            if (post[i].fl & P_DEL) {
+                *rp = r->next;
+                cc_free(r, 0);
+                --nrelocs;
+                continue;
+            }
+            r->addr = addr + post[i].at * 2;
+        }
+        rp = &r->next;
+    }
+#if PICO_RP2350
+    post_seen(addr);
+#endif
+    post_saved += (post_n - n) * sizeof(*e);
+    e = start + n - 1;
+    cc_free(post_code, 0);
+    cc_free(post, 0);
+}
+
+// dead function elimination
+
+// generate the code of function f
+static void fn_gen(struct func_s* f) {
+    f->id->val = (int)(e + 1);
+    if (f->stub) { // point the prototype's call stub at the body
+        uint16_t* te = e;
+        e = f->stub;
+        emit_word(f->id->val | 1);
+        if (ofn)
+            reloc_add((int)(e - 1));
+        e = te;
+    }
+    sw_free();
+    rv_select(f->ast, Enter_entry(f->ast).val, f->nparms);
+    if (prof_opt)
+        prof_fn = prof_add(f->id);
+    ncas = 0;
+    lineno = f->line;
+    gen(f->ast);
+    if (!nopeep_opt)
+        post_func((uint16_t*)f->id->val);
+    f->size = (e + 1 - (uint16_t*)f->id->val) * sizeof(*e);
+}
+
+// generate the functions reachable from main or from the global initializers
+static void fn_gen_live(struct ident_s* main) {
+    struct fref_s* r;
+    int more = 1;
+    main->live = 1;
+    while (more) {
+        more = 0;
+        for (r = frefs; r; r = r->next)
+            if (!r->to->live && (!r->from || r->from->id->live)) {
+                r->to->live = 1;
+                more = 1;
+            }
+    }
+    if (!src_opt) // listed functions are generated as they are parsed
+        for (struct func_s* f = funcs; f; f = f->next)
+            if (f->id->live)
+                fn_gen(f);
+    for (r = frefs; r; r = r->next)
+        if (r->data) {
+            *r->data = r->to->val | 1;
+            if (ofn)
+                reloc_add((int)r->data);
+        }
+}
+
+/* Code size of the functions left out. A listing generated them all as they were parsed.
+ * Otherwise each is generated past the live code and dropped again, along with its
+ * relocations. A function that doesn't fit in the space left isn't sized, and counts in *cnt
+ * but not in the size.
+ */
+// drop a patch list left by a function abandoned part way through, with any load locations
+static void patch_drop(struct patch_s* p) {
+    while (p) {
+        struct patch_s* t = p->next;
+        patch_drop(p->locs);
+        cc_free(p, 0);
+        p = t;
+    }
+}
+
+static int fn_dead(int* cnt) {
+    uint16_t* end = e;
+    int sz = 0, prof = prof_opt;
+    jmp_buf full;
+    prof_opt = 0;
+    for (struct func_s* f = funcs; f; f = f->next) {
+        if (f->id->live)
+            continue;
+        ++*cnt;
+        if (!src_opt) {
+            uint16_t* stub = f->stub;
+            f->stub = NULL; // the stub in the live code stays unresolved
+            size_jmp = &full;
+            if (!setjmp(full))
+                fn_gen(f);
+            else { // the pending pool and branch patches point into the abandoned code
+                patch_drop(pcrel);
+                patch_drop(brks);
+                patch_drop(cnts);
+                patch_drop(sw_jmps);
+                pcrel = brks = cnts = sw_jmps = NULL;
+                pcrel_1st = NULL;
+                pcrel_count = rs_depth = 0;
+            }
+            size_jmp = NULL;
+            f->stub = stub;
+            f->id->val = 0;
+            e = end;
+            for (struct reloc_s** rp = &relocs; *rp;) {
+                struct reloc_s* r = *rp;
+                if (r->addr > (int)end && r->addr < (int)text_end) {
+                    *rp = r->next;
+                    cc_free(r, 0);
+                    --nrelocs;
+                } else
+                    rp = &r->next;
+            }
+        }
+        sz += f->size;
     }
+    prof_opt = prof;
+    return sz;
 }
 
 static void check_label(int** tt) {
@@ -3361,7 +6308,7 @@ static void check_label(int** tt) {
     if (*ss == ':') {
         if (id->class != 0 || !(id->type == 0 || id->type == -1))
             fatal("invalid label");
-        id->type = -1; // hack for id->class deficiency
+        id->type = -2; // defined label, -1 if only the target of a goto
         ast_Label((int)id);
         ast_Begin(*tt);
         *tt = n;
@@ -3597,12 +6544,14 @@ static void stmt(int ctx) {
                     fatal("nested function");
                 if (ty > ATOM_TYPE && ty < PTR)
                     fatal("return type can't be struct");
-                if (id->class == Func && id->val > (int)text_base && id->val < (int)e &&
-                    id->forward == 0)
-                    fatal("duplicate global definition");
+                if (id->class == Func)
+                    for (struct func_s* f = funcs; f; f = f->next)
+                        if (f->id == id)
+                            fatal("duplicate global definition");
                 int ddetype = 0;
-                dd->class = Func;       // type is function
-                dd->val = (int)(e + 1); // function Pointer? offset/address
+                dd->class = Func; // type is function
+                if (!dd->forward) // a prototyped function is called through its stub
+                    dd->val = (int)(e + 1);
                 next();
                 nf = ld = 0; // "ld" is parameter's index.
                 while (tk != ')') {
@@ -3626,24 +6575,28 @@ static void stmt(int ctx) {
                 uint16_t* se;
                 if (tk == ';') { // check for prototype
                     se = e;
-                    if (!((int)e & 2))
-                        emit_nop();
-                    emit(0x4800); // ldr r0, [pc, #0]
-                    emit(0xe001); // b.n 1
-                    dd->forward = e;
-                    emit_word(0);
-                    emit(0x4700); // bx  r0
-                } else {          // function with body
+                    if (!dd->forward) {
+                        if (!((int)e & 2))
+                            emit_nop();
+                        emit(0x4800); // ldr r0, [pc, #0]
+                        emit(0xe001); // b.n 1
+                        dd->forward = e;
+                        emit_word(0);
+                        emit(0x4700); // bx  r0
+                    }
+                } else { // function with body
                     if (tk != '{')
                         fatal("bad function definition");
                     loc = ++ld;
-                    if (dd->forward) {
-                        uint16_t* te = e;
-                        e = dd->forward;
-                        emit_word(dd->val | 1);
-                        e = te;
-                        dd->forward = 0;
-                    }
+                    func_cur = cc_malloc(sizeof(struct func_s), 1, 1);
+                    func_cur->id = dd;
+                    func_cur->stub = dd->forward;
+                    dd->forward = 0;
+                    if (func_end)
+                        func_end->next = func_cur;
+                    else
+                        funcs = func_cur;
+                    func_end = func_cur;
                     next();
                     // Not declaration and must not be function, analyze inner block.
                     // e represents the address which will store pc
@@ -3659,9 +6612,14 @@ static void stmt(int ctx) {
                     if (rtf == 0 && rtt != -1)
                         fatal("expecting return value");
                     ast_Enter(ld - loc);
-                    ncas = 0;
+                    func_cur->ast = n;
+                    lsr_func(n, loc - 1);
+                    func_cur->nparms = loc - 1;
+                    func_cur->line = lineno;
                     se = e;
-                    gen(n);
+                    if (src_opt) // listed as it is parsed, else generated if reachable
+                        fn_gen(func_cur);
+                    func_cur = NULL;
                 }
                 if (src_opt) {
                     printf("%d: %.*s\n", lineno, p - lp, lp);
@@ -3669,9 +6627,15 @@ static void stmt(int ctx) {
                     disasm_address(&state, (int)(se + 1));
                     while (state.address < (int)e - 1) {
                         uint16_t* nxt = (uint16_t*)(state.address + state.size);
+                        int tab = sw_list(nxt);
+                        if (tab) { // jump table, not instructions
+                            disasm_address(&state, (int)(nxt + tab));
+                            continue;
+                        }
                         disasm_thumb(&state, *nxt, *(nxt + 1));
                         printf("%s\n", state.text);
                     }
+                    sw_free();
                 }
                 id = sym_base;
                 struct ident_s* id2 = (struct ident_s*)&sym_base;
@@ -3683,10 +6647,10 @@ static void stmt(int ctx) {
                         id->etype = id->hetype;
                         id2 = id;
                         id = id->next;
-                    } else if (id->class == Label) { // clear id for next func
-                        struct ident_s* id3 = id;
+                    } else if (id->type == -2) { // clear id for next func
+                        struct ident_s* id3 = id;    // kept for the code generation
                         id = id->next;
-                        cc_free(id3, 0);
+                        sym_remove(id3);
                         id2->next = id;
                     } else if (id->class == 0 && id->type == -1)
                         fatal("%d: label %.*s not defined\n", lineno, id->hash & 0x3f, id->name);
@@ -3715,17 +6679,23 @@ static void stmt(int ctx) {
                 if (ctx == Glo) {
                     if (sz > 1)
                         data = (char*)(((int)data + 3) & ~3);
+                    if ((data + sz) > data_end)
+                        fatal("program data exceeds data segment");
+                    // globals without an initializer go to the bss, taking no executable space
+                    if (tk == Assign) {
+                        dd->val = (int)data;
+                        data += sz;
+                    } else {
+                        data_end -= sz;
+                        dd->val = (int)data_end;
+                    }
                     if (src_opt && !dd->inserted) {
                         int len = dd->hash & 0x3f;
                         char ch = dd->name[len];
                         dd->name[len] = 0;
-                        disasm_symbol(&state, dd->name, (int)data, ARMMODE_THUMB);
+                        disasm_symbol(&state, dd->name, dd->val, ARMMODE_THUMB);
                         dd->name[len] = ch;
                     }
-                    dd->val = (int)data;
-                    if ((data + sz) > (data_base + DATA_BYTES))
-                        fatal("program data exceeds data segment");
-                    data += sz;
                 } else if (ctx == Loc) {
                     dd->val = (ld += (sz + 3) / sizeof(int));
                 } else if (ctx == Par) {
@@ -3756,6 +6726,8 @@ static void stmt(int ctx) {
                             i = ty;
                             expr(Cond);
                             typecheck(Assign, i, ty);
+                            if (ast_Tk(n) == Id && i == INT)
+                                fn_init((int*)dd->val);
                             if (ast_Tk(n) != Num && ast_Tk(n) != NumF)
                                 fatal("global assignment must eval to lit expr");
                             if (ty == CHAR + PTR && (dd->type & 3) != 1)
@@ -3791,15 +6763,26 @@ static void stmt(int ctx) {
         if (tk != ')')
             fatal("close parenthesis expected");
         next();
+        i = lbl_cnt;
         stmt(ctx);
         b = n;
+        j = lbl_cnt;
         if (tk == Else) {
             next();
             stmt(ctx);
             d = n;
         } else
             d = 0;
-        ast_Cond((int)d, (int)b, (int)a);
+        // drop the dead branch of a constant condition unless it can be entered by a label
+        if (ast_Tk(a) == Num && Num_entry(a).val && j == lbl_cnt) {
+            n = b;
+            ++fold_cnt;
+        } else if (ast_Tk(a) == Num && !Num_entry(a).val && i == j) {
+            if (!d)
+                ast_End();
+            ++fold_cnt;
+        } else
+            ast_Cond((int)d, (int)b, (int)a);
         return;
     case While:
         next();
@@ -3813,11 +6796,17 @@ static void stmt(int ctx) {
         next();
         ++brkc;
         ++cntc;
+        i = lbl_cnt;
         stmt(ctx);
         a = n; // parse body of "while"
         --brkc;
         --cntc;
-        ast_While((int)b, (int)a, While);
+        if (ast_Tk(b) == Num && !Num_entry(b).val && i == lbl_cnt) { // never entered
+            n = b + Num_words;
+            ast_End();
+            ++fold_cnt;
+        } else
+            ast_While((int)b, (int)a, While);
         return;
     case DoWhile:
         next();
@@ -3845,6 +6834,7 @@ static void stmt(int ctx) {
         i = 0;
         j = (int)ncas;
         ncas = &i;
+        int line = lineno;
         next();
         if (tk != '(')
             fatal("open parenthesis expected");
@@ -3860,7 +6850,7 @@ static void stmt(int ctx) {
         --swtc;
         --brkc;
         b = n;
-        ast_Switch((int)b, (int)a);
+        ast_Switch((int)b, (int)a, line);
         ncas = (int*)j;
         return;
     case Case:
@@ -3986,9 +6976,11 @@ static void stmt(int ctx) {
         return;
     case Goto:
         next();
-        if (tk != Id || (id->type != 0 && id->type != -1) || (id->class != Label && id->class != 0))
+        if (tk != Id || (id->type != 0 && id->type != -1 && id->type != -2) ||
+            (id->class != Label && id->class != 0))
             fatal("goto expects label");
-        id->type = -1; // hack for id->class deficiency
+        if (id->type == 0)
+            id->type = -1; // hack for id->class deficiency
         ast_Goto((int)id);
         next();
         if (tk != ';')
@@ -4125,13 +7117,17 @@ static void show_externals(int i) {
 static void help(char* lib) {
     if (!lib) {
         printf("\n"
-               "usage: cc [-s] [-u] [-n]"
+               "usage: cc [-s] [-u] [-n] [-p] [-X] [-z]"
                " [-h [lib]] [-D [symbol[ = value]]]\n"
-               "          [-o filename] filename\n"
-               "    -s      display disassembly and quit.\n"
+               "          [-o filename] filename | -C\n"
+               "    -s      display disassembly and peep-hole hits and quit.\n"
                "    -o      name of executable output file.\n"
+               "    -C      report on and clear the executable cache.\n"
                "    -u      treat char type as unsigned.\n"
-               "    -n      turn off peep-hole optimization\n"
+               "    -n      turn off peep-hole and register optimization\n"
+               "    -p      profile the program's functions, report when it ends.\n"
+               "    -X      save the executable to run in place from flash.\n"
+               "    -z      compress the executable's code and data.\n"
                "    -D symbol [= value]\n"
                "            define symbol for limited pre-processor, can repeat.\n"
                "    -h [lib name]\n"
@@ -4177,25 +7173,788 @@ void __not_in_flash_func(dummy)(void) {
 }
 #endif
 
+// largest block the heap can provide
+static int heap_avail(void) {
+    int lo = 0, hi = &__heap_end - &__heap_start;
+    while (lo < hi) {
+        int m = (lo + hi + 1) / 2;
+        void* b = malloc(m);
+        if (b) {
+            free(b);
+            lo = m;
+        } else
+            hi = m - 1;
+    }
+    return lo;
+}
+
+// code and data space a compile gets now, the free heap past the compiler's reserve split evenly
+void cc_space(int* text, int* data) {
+    heap_free = heap_avail();
+    int n = (heap_free - (heap_reserve ? heap_reserve : HEAP_RESERVE)) / 2;
+    *text = *data = (n > 0) ? n & ~3 : 0;
+}
+
+// out of heap. A compile ends to be retried with more heap reserved for its tables, while
+// that leaves room for the code and data. Otherwise this is fatal.
+void cc_heap_short(void) {
+    int r = heap_reserve ? heap_reserve : HEAP_RESERVE;
+    if (compiling && !src_opt && 2 * r < heap_free) {
+        heap_reserve = 2 * r;
+        heap_short = 1;
+        longjmp(done_jmp, 1);
+    }
+    run_fatal("out of memory");
+}
+
+// allocate zeroed code and data segments from the heap
+static void seg_alloc(int tsize, int dsize) {
+    text_seg = malloc(tsize);
+    data_seg = malloc(dsize);
+    if (!tsize || !text_seg || (dsize && !data_seg))
+        fatal("not enough memory for the program");
+    memset(text_seg, 0, tsize);
+    memset(data_seg, 0, dsize);
+    text_base = text_seg;
+    text_end = (uint16_t*)text_seg + tsize / sizeof(*e);
+    data_base = data = data_seg;
+    data_end = bss_end = data_base + dsize;
+}
+
+// hand the segment space the program leaves unused back to the heap. realloc shrinks a block
+// in place, but should it move one the segment pointers follow, and the caller relocates the
+// program to them.
+static void seg_trim(int tsize, int dsize) {
+    void* t = realloc(text_seg, tsize);
+    void* d = dsize ? realloc(data_seg, dsize) : data_seg;
+    if (t) // else the block is left as it was
+        text_seg = t;
+    if (d)
+        data_seg = d;
+    text_base = text_seg;
+    text_end = (uint16_t*)text_seg + tsize / sizeof(*e);
+    data_base = data_seg;
+}
+
+// release the segments
+static void seg_free(void) {
+    free(text_seg);
+    free(data_seg);
+    text_seg = data_seg = NULL;
+    text_base = NULL;
+    cc_heap_limit(NULL);
+}
+
+/* Under the shell's prof command a timer interrupt samples the program counter while the program
+ * runs. Each time SAMPLE_MAX samples pile up every other one is dropped and the period doubles,
+ * so a long run keeps an even spread of them. The samples in the code segment are resolved with
+ * the function symbol table, which is also saved at the end of the executables.
+ */
+
+static int sample_on;              // set by the shell to sample the next program run
+static char* fsym_tbl UDATA;       // function symbols, offset in the code and name
+static int fsym_size UDATA;        // function symbols size in bytes
+static uint32_t* sample_buf UDATA; // sampled program counters
+static int sample_cnt UDATA;       // sample count
+static uint32_t sample_us UDATA;   // sampling period
+static int sample_alarm UDATA;     // hardware alarm driving the sampling
+static int sampling UDATA;         // the sampling interrupt is enabled
+
+void cc_sample(int on) { sample_on = on; }
+
+static int time_on; // set by the shell to time the next program run
+
+void cc_time(int on) { time_on = on; }
+
+// build the symbol table of the generated functions, in address order. Each entry is a 32 bit
+// code segment offset followed by the NUL terminated name.
+static void fsym_build(void) {
+    struct func_s* f;
+    int sz = 0;
+    for (f = funcs; f; f = f->next)
+        if (f->id->live || src_opt) // a listing generates them all
+            sz += sizeof(uint32_t) + (f->id->hash & 0x3f) + 1;
+    if (!sz)
+        return;
+    char* t = fsym_tbl = malloc(sz);
+    if (!t)
+        cc_heap_short();
+    for (f = funcs; f; f = f->next)
+        if (f->id->live || src_opt) {
+            int len = f->id->hash & 0x3f;
+            uint32_t ofs = f->id->val - (int)text_base;
+            memcpy(t, &ofs, sizeof(ofs));
+            t += sizeof(ofs);
+            memcpy(t, f->id->name, len);
+            t[len] = 0;
+            t += len + 1;
+        }
+    fsym_size = sz;
+}
+
+// the timer interrupt, passes the program counter of the stacked exception frame to the sampler
+__attribute__((naked)) static void sample_isr(void) {
+    asm volatile("mov  r0, lr       \n" // EXC_RETURN, bit 2 set if the frame is on the psp
+                 "movs r1, #4       \n"
+                 "tst  r0, r1       \n"
+                 "bne  1f           \n"
+                 "mrs  r0, msp      \n"
+                 "b    2f           \n"
+                 "1:                \n"
+                 "mrs  r0, psp      \n"
+                 "2:                \n"
+                 "ldr  r0, [r0, #24]\n"
+                 "push {r1, lr}     \n"
+                 "bl   cc_sample_tick\n"
+                 "pop  {r1, pc}     \n");
+}
+
+// take a sample, called by sample_isr with the interrupted program counter
+__attribute__((used)) void cc_sample_tick(uint32_t pc) {
+    timer_hw->intr = 1u << sample_alarm;
+    if (sample_cnt == SAMPLE_MAX) { // keep every other sample, sample half as often
+        for (int i = 0; i < SAMPLE_MAX / 2; i++)
+            sample_buf[i] = sample_buf[2 * i + 1];
+        sample_cnt = SAMPLE_MAX / 2;
+        sample_us *= 2;
+    }
+    sample_buf[sample_cnt++] = pc;
+    timer_hw->alarm[sample_alarm] = timer_hw->timerawl + sample_us;
+}
+
+static void sample_start(void) {
+    sample_buf = malloc(SAMPLE_MAX * sizeof(uint32_t));
+    if (!sample_buf)
+        fatal("out of memory");
+    sample_alarm = hardware_alarm_claim_unused(false);
+    if (sample_alarm < 0)
+        fatal("no timer alarm free to sample with");
+    sample_cnt = 0;
+    sample_us = SAMPLE_US;
+    int irq = hardware_alarm_get_irq_num(sample_alarm);
+    irq_set_exclusive_handler(irq, sample_isr);
+    hw_set_bits(&timer_hw->inte, 1u << sample_alarm);
+    irq_set_enabled(irq, true);
+    sampling = 1;
+    timer_hw->alarm[sample_alarm] = timer_hw->timerawl + sample_us;
+}
+
+static void sample_stop(void) {
+    if (!sampling)
+        return;
+    int irq = hardware_alarm_get_irq_num(sample_alarm);
+    irq_set_enabled(irq, false);
+    hw_clear_bits(&timer_hw->inte, 1u << sample_alarm);
+    timer_hw->armed = 1u << sample_alarm;
+    timer_hw->intr = 1u << sample_alarm;
+    irq_remove_handler(irq, sample_isr);
+    hardware_alarm_unclaim(sample_alarm);
+    sampling = 0;
+}
+
+#define FSYM_NAME(s) ((s) + sizeof(uint32_t)) // name of function symbol s
+
+static const char* fsym_next(const char* s) { return FSYM_NAME(s) + strlen(FSYM_NAME(s)) + 1; }
+
+// the symbol of the function at code segment offset ofs, NULL if none
+static const char* fsym_find(uint32_t ofs) {
+    const char *t = fsym_tbl, *s = NULL;
+    for (; t < fsym_tbl + fsym_size; t = fsym_next(t)) {
+        uint32_t a;
+        memcpy(&a, t, sizeof(a));
+        if (a > ofs)
+            break;
+        s = t;
+    }
+    return s;
+}
+
+struct sample_hit_s {
+    const char* sym; // function symbol, NULL outside the program
+    int cnt;         // samples in the function
+};
+
+static int sample_cmp(const void* a, const void* b) {
+    const struct sample_hit_s *x = a, *y = b;
+    return y->cnt - x->cnt;
+}
+
+// print the functions by number of samples, and write the samples to prof.out
+static void sample_report(uint32_t tsize) {
+    int n = 0;
+    for (const char* s = fsym_tbl; s < fsym_tbl + fsym_size; s = fsym_next(s))
+        ++n;
+    struct sample_hit_s* hit = cc_malloc((n + 1) * sizeof(struct sample_hit_s), 1, 1);
+    n = 0;
+    for (const char* s = fsym_tbl; s < fsym_tbl + fsym_size; s = fsym_next(s))
+        hit[n++].sym = s;
+    // count the samples of each function, the last entry counting those outside the program
+    char* fn = full_path("prof.out");
+    fd = cc_malloc(sizeof(lfs_file_t), 1, 1);
+    int err = fs_file_open(fd, fn, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) < LFS_ERR_OK;
+    int open = !err;
+    char line[48];
+    if (!err) {
+        sprintf(line, "# every %d us, code at %08x\n", sample_us, (int)text_base);
+        err = fs_file_write(fd, line, strlen(line)) < LFS_ERR_OK;
+    }
+    for (int i = 0; i < sample_cnt; i++) {
+        uint32_t ofs = sample_buf[i] - (uint32_t)text_base;
+        const char* s = (ofs < tsize) ? fsym_find(ofs) : NULL;
+        int j = 0;
+        while (j < n && hit[j].sym != s)
+            ++j;
+        ++hit[j].cnt;
+        if (!err) {
+            sprintf(line, "%08x %.32s\n", sample_buf[i], s ? FSYM_NAME(s) : "(firmware)");
+            err = fs_file_write(fd, line, strlen(line)) < LFS_ERR_OK;
+        }
+    }
+    if (open && fs_file_close(fd) < LFS_ERR_OK)
+        err = 1;
+    cc_free(fd, 0);
+    fd = NULL;
+    qsort(hit, n + 1, sizeof(struct sample_hit_s), sample_cmp);
+    printf("\nsampled every %d us\n", sample_us);
+    printf("   samples      %%  function\n");
+    for (int i = 0; i <= n && hit[i].cnt; i++)
+        printf("%10d %5d%%  %s\n", hit[i].cnt, hit[i].cnt * 100 / sample_cnt,
+               hit[i].sym ? FSYM_NAME(hit[i].sym) : "(firmware)");
+    printf(err ? "error writing %s\n" : "samples in %s\n", fn);
+    cc_free(hit, 0);
+}
+
+static void sample_free(void) {
+    sample_stop();
+    free(sample_buf);
+    free(fsym_tbl);
+    sample_buf = NULL;
+    fsym_tbl = NULL;
+    fsym_size = 0;
+}
+
 // executable file header
 struct exe_s {
-    uint32_t entry;      // entry point
-    uint16_t tsize;      // text segment size
-    uint16_t nreloc;     // # of external function relocation entries
-    uint32_t dsize : 24; // data segment size
-    uint32_t ccver : 8;  // exec version
+    uint32_t entry;       // entry point
+    uint32_t tsize;       // text segment size
+    uint32_t dsize : 24;  // data segment size
+    uint32_t ccver : 8;   // exec version
+    uint32_t nreloc : 24; // # of relocation entries
+    uint32_t xip : 8;     // 1 if the code runs in place from flash
+    uint32_t tbase;       // text segment address when compiled
+    uint32_t dbase;       // data segment address when compiled
+    uint32_t rsize;       // relocation table size in bytes
+    uint32_t ztsize;      // compressed text segment size, 0 if stored as is
+    uint32_t zdsize;      // compressed data segment size, 0 if stored as is
+    uint32_t bsize;       // bss size, zeroed by the loader and not stored
+    uint32_t bbase;       // bss address when compiled
+    uint32_t ssize;       // function symbol table size in bytes
+};
+
+// offset of the bss in the loaded data segment, which it follows
+#define BSS_OFS(exe) (((exe)->dsize + 3) & ~3)
+
+// fill in the header of the compiled program
+static void exe_header(struct exe_s* exe) {
+    exe->tsize = ((e + 1) - text_base) * sizeof(*e);
+    exe->dsize = data - data_base;
+    exe->ccver = CC_VERSION;
+    exe->nreloc = nrelocs;
+    exe->xip = xip_opt;
+    exe->ztsize = exe->zdsize = 0;
+    exe->tbase = (int)text_base;
+    exe->dbase = (int)data_base;
+    exe->bsize = bss_end - data_end;
+    exe->bbase = (int)data_end;
+    exe->ssize = fsym_size;
+}
+
+/* Executables saved with -X run their code in place from the flash area at fs_xip_base(). The
+ * first run installs the code there with its relocations resolved, and tags the executable with
+ * the install id. The data segment then sits at a fixed address at the top of the heap, the one
+ * the code was resolved for, and the heap is held under it while the program runs.
+ */
+
+// FNV-1a hash of l bytes at d, continuing from h
+static uint32_t cache_hash(uint32_t h, const void* d, int l) {
+    for (const uint8_t* c = d; l > 0; l--)
+        h = (h ^ *c++) * 16777619u;
+    return h;
+}
+
+// hash of the firmware addresses compiled code depends on, the external functions and heap end
+static uint32_t fw_hash(void) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < NUMOF(externs); i++)
+        h = cache_hash(h, &externs[i].extrn, sizeof(externs[i].extrn));
+#if PICO_RP2040
+    h = cache_hash(h, fops, sizeof(fops));
+#endif
+    const char* he = &__heap_end;
+    return cache_hash(h, &he, sizeof(he));
+}
+
+#define XIP_MAGIC 0x50495843 // installed code mark
+#define XIP_ATTR 3           // littlefs attribute type of the install id
+#define XIP_SECTOR (4 * K)   // flash erase sector, installed code starts on one
+
+struct xip_s {
+    uint32_t magic;                     // XIP_MAGIC
+    uint32_t id;                        // install id, a code hash, the executable's XIP_ATTR
+    uint32_t tsize;                     // text segment size
+    uint32_t fw;                        // fw_hash() of the firmware the code was resolved for
+};
+
+// the code installed as id, or NULL. *end is set to the offset past the installed code.
+static const struct xip_s* xip_find(uint32_t id, uint32_t tsize, int* end) {
+    const struct xip_s *x, *m = NULL;
+    int off = 0;
+    while (off < fs_xip_size()) {
+        x = (const struct xip_s*)((const char*)fs_xip_base() + off);
+        if (x->magic != XIP_MAGIC || x->tsize > fs_xip_size())
+            break;
+        if (x->id == id && x->tsize == tsize && x->fw == fw_hash())
+            m = x;
+        off += (sizeof(*x) + x->tsize + XIP_SECTOR - 1) & ~(XIP_SECTOR - 1);
+    }
+    *end = off;
+    return m;
+}
+
+// read n compressed bytes from the executable and expand them into the size bytes at d
+static void lz_load(uint8_t* d, int size, int n) {
+    uint8_t* buf = cc_malloc(n, 1, 0);
+    if (fs_file_read(fd, buf, n) != n)
+        fatal("error reading %s", ofn);
+    if (lz_unpack(d, size, buf, n))
+        fatal("%s is corrupted", ofn);
+    cc_free(buf, 0);
+}
+
+// read a segment of the executable into d, compressed into zsize bytes if not 0
+static void seg_load(void* d, int size, int zsize) {
+    if (zsize)
+        lz_load(d, size, zsize);
+    else if (size && fs_file_read(fd, d, size) != size)
+        fatal("error reading %s", ofn);
+}
+
+// write the size bytes at s to the executable, compressed if the packed copy at z is smaller
+static int seg_write(const void* s, int size, const uint8_t* z, uint32_t zsize) {
+    if (zsize)
+        return fs_file_write(fd, z, zsize) != zsize;
+    return size && fs_file_write(fd, s, size) != size;
+}
+
+/* The relocation table lists the words to patch by their offset in the loaded image, the code
+ * segment rounded up to a word followed by the data segment. The offsets are sorted and each is
+ * stored as its distance in words from the previous one, 7 bits per byte, low bits first, with
+ * the top bit set on all but the last byte. Most relocations are a few words apart and take a
+ * single byte.
+ */
+
+static int reloc_cmp(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// encode the relocation table, *size is set to its length
+static uint8_t* reloc_table(struct exe_s* exe, int* size) {
+    uint32_t* ofs = cc_malloc(nrelocs * sizeof(uint32_t) + 1, 1, 0);
+    uint8_t* tbl = cc_malloc(nrelocs * 5 + 1, 1, 0);
+    uint32_t tsz = (exe->tsize + 3) & ~3, n = 0, last = 0;
+    for (struct reloc_s* r = relocs; r; r = r->next)
+        ofs[n++] = r->addr - exe->tbase < exe->tsize ? r->addr - exe->tbase
+                                                     : tsz + r->addr - exe->dbase;
+    qsort(ofs, n, sizeof(uint32_t), reloc_cmp);
+    uint8_t* t = tbl;
+    for (int i = 0; i < n; i++) {
+        uint32_t d = (ofs[i] - last) / 4;
+        last = ofs[i];
+        for (; d > 0x7f; d >>= 7)
+            *t++ = d | 0x80;
+        *t++ = d;
+    }
+    cc_free(ofs, 0);
+    *size = t - tbl;
+    return tbl;
+}
+
+// write the compiled program to an executable file, 0 if successful
+static int exe_write(const char* fn, struct exe_s* exe) {
+    int rsize;
+    uint8_t* tbl = reloc_table(exe, &rsize);
+    exe->rsize = rsize;
+    // compress the segments, each kept as is unless that saves space
+    uint8_t *ztext = NULL, *zdata = NULL;
+    if (zip_opt) {
+        int* work = cc_malloc(LZ_WORK, 1, 0);
+        ztext = cc_malloc(LZ_BOUND(exe->tsize), 1, 0);
+        exe->ztsize = lz_pack((uint8_t*)text_base, exe->tsize, ztext, work);
+        if (exe->ztsize >= exe->tsize)
+            exe->ztsize = 0;
+        zdata = cc_malloc(LZ_BOUND(exe->dsize), 1, 0);
+        exe->zdsize = lz_pack((uint8_t*)data_base, exe->dsize, zdata, work);
+        if (exe->zdsize >= exe->dsize)
+            exe->zdsize = 0;
+        cc_free(work, 0);
+    }
+    fd = cc_malloc(sizeof(lfs_file_t), 1, 1);
+    int err = fs_file_open(fd, fn, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) < LFS_ERR_OK;
+    if (!err) {
+        // write the header, the code and data segments, the relocation and symbol tables
+        err = fs_file_write(fd, exe, sizeof(*exe)) != sizeof(*exe) ||
+              seg_write(text_base, exe->tsize, ztext, exe->ztsize) ||
+              seg_write(data_base, exe->dsize, zdata, exe->zdsize) ||
+              (rsize && fs_file_write(fd, tbl, rsize) != rsize) ||
+              (fsym_size && fs_file_write(fd, fsym_tbl, fsym_size) != fsym_size);
+        fs_file_close(fd);
+    }
+    cc_free(fd, 0);
+    fd = NULL;
+    if (zip_opt) {
+        cc_free(zdata, 0);
+        cc_free(ztext, 0);
+    }
+    cc_free(tbl, 0);
+    // set the executable attribute
+    if (!err)
+        err = fs_setattr(fn, 1, "exe", 4) < LFS_ERR_OK;
+    fs_removeattr(fn, XIP_ATTR); // any installed code is stale
+    return err ? -1 : 0;
+}
+
+// where the address a compiled at exe->tbase, dbase or bbase is loaded, 0 if outside them
+static int exe_addr(struct exe_s* exe, uint32_t a) {
+    if (a - exe->tbase < exe->tsize)
+        return a - exe->tbase + (int)text_base;
+    if (a - exe->bbase <= exe->bsize) // one past the end of the bss too
+        return a - exe->bbase + (int)data_base + BSS_OFS(exe);
+    if (a - exe->dbase <= exe->dsize)
+        return a - exe->dbase + (int)data_base;
+    return 0;
+}
+
+// point a segment address at the loaded segment, or an external reference at its target
+static void exe_reloc(struct exe_s* exe, int addr) {
+    int v = *((int*)addr);
+    if (exe_addr(exe, v))
+        *((int*)addr) = exe_addr(exe, v);
+    else if (v < 0) {
+#if PICO_RP2040
+        *((int*)addr) = (int)fops[-v];
+#endif
+    } else {
+        if (IS_PRINTF(&externs[v]))
+            *((int*)addr) = (int)x_printf;
+        else if (IS_SPRINTF(&externs[v]))
+            *((int*)addr) = (int)x_sprintf;
+        else
+            *((int*)addr) = (int)externs[v].extrn;
+    }
+}
+
+/* Read the relocation table in one transfer and apply it. The code words are patched where text
+ * points, the code as read from the file, and skipped if text is NULL.
+ */
+static void exe_relocate(struct exe_s* exe, char* text) {
+    if (!exe->rsize)
+        return;
+    uint8_t* tbl = cc_malloc(exe->rsize, 1, 0);
+    if (fs_file_read(fd, tbl, exe->rsize) != exe->rsize)
+        fatal("error reading %s", ofn);
+    uint32_t tsz = (exe->tsize + 3) & ~3, off = 0;
+    for (uint8_t *t = tbl, *te = tbl + exe->rsize; t < te;) {
+        uint32_t d = 0;
+        for (int sh = 0;; sh += 7) {
+            d |= (*t & 0x7f) << sh;
+            if (!(*t++ & 0x80))
+                break;
+        }
+        off += d * 4;
+        if (off >= tsz)
+            exe_reloc(exe, (int)data_base + off - tsz);
+        else if (text)
+            exe_reloc(exe, (int)text + off);
+    }
+    cc_free(tbl, 0);
+}
+
+// load an executable whose code runs in place, installing the code first if it is not
+static void xip_load(struct exe_s* exe) {
+    if (!fs_xip_size())
+        fatal("no flash area to run %s in place, build with XIP_AREA", ofn);
+    // the data segment at the top of the heap, the heap held under it
+    data_base = (char*)(((int)&__heap_end - BSS_OFS(exe) - exe->bsize) & ~7);
+    data_end = bss_end = data_base + BSS_OFS(exe) + exe->bsize;
+    if ((char*)sbrk(0) > data_base)
+        malloc_trim(0);
+    if ((char*)sbrk(0) > data_base)
+        fatal("not enough memory to run %s", ofn);
+    cc_heap_limit(data_base);
+    // find the installed code, or make room to install it
+    uint32_t id = 0;
+    int end;
+    fs_getattr(ofn, XIP_ATTR, &id, sizeof(id));
+    const struct xip_s* x = xip_find(id, exe->tsize, &end);
+    struct xip_s* img = NULL;
+    int sz = (sizeof(*img) + exe->tsize + XIP_SECTOR - 1) & ~(XIP_SECTOR - 1);
+    if (x) {
+        text_base = (const uint16_t*)(x + 1);
+        fs_file_seek(fd, exe->ztsize ? exe->ztsize : exe->tsize, SEEK_CUR);
+    } else {
+        if (sz > fs_xip_size())
+            fatal("%s is too big to run in place", ofn);
+        if (end + sz > fs_xip_size()) { // start over
+            if (fs_xip_erase(0, fs_xip_size()) < LFS_ERR_OK)
+                fatal("error erasing the flash area");
+            end = 0;
+        }
+        img = cc_malloc(sizeof(*img) + exe->tsize, 1, 0);
+        img->magic = XIP_MAGIC;
+        img->tsize = exe->tsize;
+        img->fw = fw_hash();
+        text_base = (const uint16_t*)((const char*)fs_xip_base() + end + sizeof(*img));
+        seg_load(img + 1, exe->tsize, exe->ztsize);
+    }
+    seg_load(data_base, exe->dsize, exe->zdsize);
+    memset(data_base + BSS_OFS(exe), 0, exe->bsize);
+    // relocate the data, and the code when installing it
+    exe_relocate(exe, img ? (char*)(img + 1) : NULL);
+    if (img) {
+        // the id is a hash of the relocated code, which unlike a time doesn't repeat after a reboot
+        img->id = cache_hash(2166136261u, img + 1, exe->tsize);
+        if (img->id == 0) // 0 is no install
+            img->id = 1;
+        if (fs_xip_erase(end, sz) < LFS_ERR_OK ||
+            fs_xip_prog(end, img, sizeof(*img) + exe->tsize) < LFS_ERR_OK)
+            fatal("error installing %s", ofn);
+        fs_setattr(ofn, XIP_ATTR, &img->id, sizeof(img->id));
+        cc_free(img, 0);
+    }
+}
+
+// load the executable file ofn and resolve its external references, returns the load time in us
+static uint32_t exe_load(struct exe_s* exe) {
+    uint32_t t0 = time_us_32();
+    // check file attribute
+    char buf[4];
+    if (fs_getattr(ofn, 1, buf, sizeof(buf)) != 4)
+        fatal("file %s not found or not executable", ofn);
+    if (memcmp(buf, "exe", 4))
+        fatal("file %s not found or not executable", ofn);
+    // allocate file descriptor and open binary executable file
+    fd = cc_malloc(sizeof(lfs_file_t), 1, 1);
+    if (fs_file_open(fd, ofn, LFS_O_RDONLY) < LFS_ERR_OK)
+        fatal("can't open file %s", ofn);
+    // read the exe header
+    if (fs_file_read(fd, exe, sizeof(*exe)) != sizeof(*exe)) {
+        fs_file_close(fd);
+        fatal("error reading %s", ofn);
+    }
+    if (exe->ccver != CC_VERSION)
+        fatal("executable compiled with earlier incompatible version, please recompile");
+    seg_free();
+    if (exe->xip)
+        xip_load(exe);
+    else {
+        // reserve the segments, read in the code and data
+        seg_alloc(exe->tsize, BSS_OFS(exe) + exe->bsize);
+        seg_load(text_seg, exe->tsize, exe->ztsize);
+        seg_load(data_seg, exe->dsize, exe->zdsize);
+        // relocate the segment addresses and set the external function calls
+        exe_relocate(exe, (char*)text_seg);
+    }
+    // the function symbols follow, read only to sample the program
+    if (sample_on && exe->ssize) {
+        fsym_tbl = malloc(exe->ssize);
+        if (!fsym_tbl || fs_file_read(fd, fsym_tbl, exe->ssize) != exe->ssize)
+            fatal("error reading %s", ofn);
+        fsym_size = exe->ssize;
+    }
+    exe->entry = exe_addr(exe, exe->entry);
+    // close the file and free its descriptor
+    fs_file_close(fd);
+    cc_free(fd, 1);
+    fd = NULL;
+    return time_us_32() - t0;
+}
+
+// Executable cache. Running a source file compiles it into CACHE_DIR, named by a hash of the
+// source, the options and the compiler version. Later runs of the same source load the cached
+// executable instead. Least recently used entries are evicted beyond CACHE_BYTES.
+
+#define CACHE_DIR "/.cccache"
+#define CACHE_BYTES (64 * K) // cache size budget
+#define CACHE_ATTR 2         // littlefs attribute type of the cache bookkeeping
+
+struct cache_ent_s {
+    uint32_t seq; // last use sequence number
+    uint32_t us;  // compile time
 };
 
+struct cache_stat_s {
+    uint32_t hits, misses;
+    uint32_t saved_us; // compile time saved by hits
+    uint32_t load_us;  // time spent loading the hits
+};
+
+static uint32_t cache_key UDATA; // FNV-1a hash of the source and options
+static char cache_fn[24] UDATA;  // cache entry file name, empty if not caching
+
+/* Walk the cache entries, removing all of them if clear is set. Otherwise evict the least
+ * recently used entries other than cache_fn while over budget. Returns the highest sequence
+ * number in use.
+ */
+static uint32_t cache_scan(int clear) {
+    lfs_dir_t* dir = cc_malloc(sizeof(lfs_dir_t), 1, 1);
+    struct lfs_info* info = cc_malloc(sizeof(struct lfs_info), 1, 1);
+    char* fn = cc_malloc(sizeof(CACHE_DIR) + sizeof(info->name), 1, 1);
+    char* lru = cc_malloc(sizeof(CACHE_DIR) + sizeof(info->name), 1, 1);
+    uint32_t max, min, size;
+    struct cache_ent_s ent;
+    do {
+        max = size = 0;
+        min = UINT32_MAX;
+        if (fs_dir_open(dir, CACHE_DIR) < LFS_ERR_OK)
+            break;
+        while (fs_dir_read(dir, info) > 0) {
+            if (info->type != LFS_TYPE_REG)
+                continue;
+            sprintf(fn, CACHE_DIR "/%s", info->name);
+            if (clear) {
+                fs_remove(fn);
+                continue;
+            }
+            if (fs_getattr(fn, CACHE_ATTR, &ent, sizeof(ent)) != sizeof(ent))
+                ent.seq = 0;
+            size += info->size;
+            if (ent.seq > max)
+                max = ent.seq;
+            if (ent.seq < min && strcmp(fn, cache_fn)) {
+                min = ent.seq;
+                strcpy(lru, fn);
+            }
+        }
+        fs_dir_close(dir);
+    } while (!clear && size > CACHE_BYTES && min != UINT32_MAX && fs_remove(lru) >= LFS_ERR_OK);
+    cc_free(lru, 0);
+    cc_free(fn, 0);
+    cc_free(info, 0);
+    cc_free(dir, 0);
+    return max;
+}
+
+static void cache_stat(struct cache_stat_s* st) {
+    if (fs_getattr(CACHE_DIR, CACHE_ATTR, st, sizeof(*st)) != sizeof(*st))
+        memset(st, 0, sizeof(*st));
+}
+
+// look up the source in the cache, 1 if the executable is cached and now loaded
+static int cache_lookup(struct exe_s* exe) {
+    struct cache_stat_s st;
+    struct cache_ent_s ent;
+    char buf[4];
+    sprintf(cache_fn, CACHE_DIR "/%08x", cache_key);
+    cache_stat(&st);
+    if (fs_getattr(cache_fn, 1, buf, sizeof(buf)) != 4 || memcmp(buf, "exe", 4) ||
+        fs_getattr(cache_fn, CACHE_ATTR, &ent, sizeof(ent)) != sizeof(ent)) {
+        ++st.misses;
+        fs_mkdir(CACHE_DIR);
+        fs_setattr(CACHE_DIR, CACHE_ATTR, &st, sizeof(st));
+        return 0;
+    }
+    fs_file_close(fd); // the source
+    cc_free(fd, 0);
+    fd = NULL;
+    ofn = cache_fn;
+    ++st.hits;
+    st.saved_us += ent.us;
+    st.load_us += exe_load(exe);
+    fs_setattr(CACHE_DIR, CACHE_ATTR, &st, sizeof(st));
+    ent.seq = cache_scan(0) + 1;
+    fs_setattr(cache_fn, CACHE_ATTR, &ent, sizeof(ent));
+    return 1;
+}
+
+// add the compiled program to the cache
+static void cache_store(struct exe_s* exe, uint32_t us) {
+    struct cache_ent_s ent;
+    if (exe_write(cache_fn, exe)) {
+        fs_remove(cache_fn); // out of space, run uncached
+        return;
+    }
+    ent.seq = cache_scan(0) + 1;
+    ent.us = us;
+    fs_setattr(cache_fn, CACHE_ATTR, &ent, sizeof(ent));
+}
+
+// report the cache statistics and empty it
+static void cache_clear(void) {
+    struct cache_stat_s st;
+    cache_stat(&st);
+    int n = st.hits + st.misses;
+    printf("\ncache hits %d of %d (%d%%), %d ms compile time saved, %d us average load\n",
+           st.hits, n, n ? st.hits * 100 / n : 0, st.saved_us / 1000,
+           st.hits ? st.load_us / st.hits : 0);
+    cache_scan(1);
+    fs_removeattr(CACHE_DIR, CACHE_ATTR);
+}
+
+static int prof_cmp(const void* a, const void* b) {
+    const struct prof_s *x = a, *y = b;
+    return (x->self < y->self) - (x->self > y->self);
+}
+
+// print the flat profile, most time consuming functions first
+static void prof_report(void) {
+    uint32_t all = 0;
+    for (int i = 0; i < prof_cnt; i++)
+        all += prof_tbl[i].self;
+    qsort(prof_tbl, prof_cnt, sizeof(struct prof_s), prof_cmp);
+#if PICO_RP2350
+    printf("\nprofile, times in cycles\n");
+#else
+    printf("\nprofile, times in us\n");
+#endif
+    printf("     calls       self      total  self%%  function\n");
+    for (int i = 0; i < prof_cnt; i++) {
+        struct prof_s* p = prof_tbl + i;
+        if (p->calls)
+            printf("%10u %10u %10u %5d%%  %s\n", p->calls, p->self, p->total,
+                   all ? (int)((uint64_t)p->self * 100 / all) : 0, p->name);
+    }
+}
+
+static void prof_free(void) {
+    for (int i = 0; i < prof_cnt; i++)
+        free(prof_tbl[i].name);
+    free(prof_tbl);
+    free(prof_stk);
+    prof_tbl = NULL;
+    prof_stk = NULL;
+    prof_cnt = 0;
+}
+
 // compiler can be invoked in compile mode (mode = 0)
 // or loader mode (mode = 1)
 int cc(int mode, int argc, char** argv) {
-
+    // the arguments as passed, a compile retried with more heap starts over from them
+    int volatile argc0 = argc;
+    char** volatile argv0 = argv;
+    int volatile retry = 0;
+
+restart:
+    argc = argc0;
+    argv = argv0;
     // clear uninitialized global variables
     extern char __ccudata_start__, __ccudata_end__;
     memset(&__ccudata_start__, 0, &__ccudata_end__ - &__ccudata_start__);
     extern const char* pshell_version;
     int rslt = -1;
     struct exe_s exe;
+    uint32_t t_start = time_us_32();
+    const char* t_what = "load"; // what the time to launch went to
 
     // set the abort jump
     if (setjmp(done_jmp))
@@ -4207,6 +7966,7 @@ int cc(int mode, int argc, char** argv) {
         for (int i = 1; i < NUMOF(externs); i++)
             if (strcmp(externs[i].name, externs[i - 1].name) <= 0)
                 run_fatal("out of order starting at %s\n %s", externs[i - 1].name, externs[i].name);
+        sym_grow();
         // Register keywords in symbol table. Must match the sequence of enum
         p = "enum char int float struct union sizeof return goto break continue "
             "if do while for switch case default else void main";
@@ -4229,9 +7989,12 @@ int cc(int mode, int argc, char** argv) {
         struct ident_s* idmain = id;
         id->class = Main; // keep track of main
 
-        // set data segment bases
-        data_base = data = __StackLimit + TEXT_BYTES;
-        memset(__StackLimit, 0, TEXT_BYTES + DATA_BYTES);
+        // size the code and data segments from the free heap
+        int tsz, dsz;
+        cc_space(&tsz, &dsz);
+        seg_alloc(tsz, dsz);
+        compiling = 1;
+        peep_init();
         // allocate the type size and abstract syntax tree
         tsize = cc_malloc(TS_TBL_BYTES, 1, 1);
         ast = cc_malloc(AST_TBL_BYTES, 1, 1);
@@ -4243,10 +8006,16 @@ int cc(int mode, int argc, char** argv) {
         tsize[tnew++] = sizeof(float);
         tsize[tnew++] = 0; // reserved for another scalar type
 
-        // parse the command line arguments
+        // parse the command line arguments, the options are part of the cache key
+        uint8_t ver = CC_VERSION;
+        cache_key = cache_hash(2166136261u, &ver, sizeof(ver));
+        // cached code holds firmware addresses, moving any of them invalidates it
+        uint32_t fw = fw_hash();
+        cache_key = cache_hash(cache_key, &fw, sizeof(fw));
         --argc;
         ++argv;
         while (argc > 0 && **argv == '-') {
+            cache_key = cache_hash(cache_key, *argv, strlen(*argv) + 1);
             if ((*argv)[1] == 'h') {
                 --argc;
                 ++argv;
@@ -4257,6 +8026,9 @@ int cc(int mode, int argc, char** argv) {
                 goto done;
             } else if ((*argv)[1] == 's') {
                 src_opt = 1;
+            } else if ((*argv)[1] == 'C') {
+                cache_clear();
+                goto done;
             } else if ((*argv)[1] == 'n') {
                 nopeep_opt = 1;
             } else if ((*argv)[1] == 'o') {
@@ -4266,6 +8038,12 @@ int cc(int mode, int argc, char** argv) {
                     ofn = *argv;
             } else if ((*argv)[1] == 'u') {
                 uchar_opt = 1;
+            } else if ((*argv)[1] == 'X') {
+                xip_opt = 1;
+            } else if ((*argv)[1] == 'z') {
+                zip_opt = 1;
+            } else if ((*argv)[1] == 'p') {
+                prof_opt = 1;
             } else if ((*argv)[1] == 'D') {
                 p = &(*argv)[2];
                 next();
@@ -4295,6 +8073,8 @@ int cc(int mode, int argc, char** argv) {
             help(NULL);
             goto done;
         }
+        if (prof_opt && ofn)
+            fatal("a profiled program can't be saved");
 
         // optionally enable and add known symbols to disassembler tables
         if (src_opt) {
@@ -4312,6 +8092,10 @@ int cc(int mode, int argc, char** argv) {
             disasm_symbol(&state, "fcmpgt", (uint32_t)__wrap___aeabi_fcmpgt, ARMMODE_THUMB);
             disasm_symbol(&state, "fcmplt", (uint32_t)__wrap___aeabi_fcmplt, ARMMODE_THUMB);
 #endif
+            if (prof_opt) {
+                disasm_symbol(&state, "prof_enter", (uint32_t)prof_enter, ARMMODE_THUMB);
+                disasm_symbol(&state, "prof_leave", (uint32_t)prof_leave, ARMMODE_THUMB);
+            }
         }
 
         // add SDK and clib symbols
@@ -4338,25 +8122,32 @@ int cc(int mode, int argc, char** argv) {
         }
         // don't need the filename anymore
         cc_free(fn, 0);
-        // get the file size
-        int fl = fs_file_seek(fd, 0, SEEK_END);
-        fs_file_seek(fd, 0, SEEK_SET);
-        // allocate the source buffer, terminate it, then close the file
-        src_base = p = lp = cc_malloc(fl + 1, 1, 1);
-        // move the file contents to the source buffer
-        if (fs_file_read(fd, src_base, fl) != fl)
-            fatal("error reading source");
-        src_base[fl] = 0;
-        fs_file_close(fd);
-        // free the file descriptor
-        cc_free(fd, 0);
-        fd = 0;
+        // allocate the source window, the file stays open while compiling
+        src_base = src_end = p = lp = cc_malloc(SRC_BYTES + 1, 1, 1);
+
+        // a program that is run rather than listed or saved goes through the cache, unless
+        // profiled
+        if (!ofn && !src_opt) {
+            if (!prof_opt) {
+                int l;
+                while ((l = fs_file_read(fd, src_base, SRC_BYTES)) > 0)
+                    cache_key = cache_hash(cache_key, src_base, l);
+                fs_file_seek(fd, 0, SEEK_SET);
+                if (retry) // the lookup missed the first time
+                    sprintf(cache_fn, CACHE_DIR "/%08x", cache_key);
+                else if (cache_lookup(&exe))
+                    goto run;
+            }
+            ofn = cache_fn; // compile for the cache, the profiler relocates in place just the same
+        }
+        uint32_t t0 = time_us_32();
+        src_fill();
 
         // set the code base
 #if EXE_DBG
         text_base = le = (uint16_t*)((int)dummy & ~1);
 #else
-        text_base = le = (uint16_t*)__StackLimit;
+        le = (uint16_t*)text_base;
 #endif
         e = (uint16_t*)text_base - 1;
 
@@ -4375,17 +8166,32 @@ int cc(int mode, int argc, char** argv) {
         for (id = sym_base; id; id = id->next)
             if (id->class == Func && id->forward)
                 fatal("undeclared forward function %.*s", id->hash & 0x3f, id->name);
+        // generate the functions in use, and size the others when they are reported
+        fn_gen_live(idmain);
+        int dead_cnt = 0, dead_sz = 0;
+        if (src_opt || (ofn && ofn != cache_fn))
+            dead_sz = fn_dead(&dead_cnt);
 
-        // free all the compiler buffers
+        // close the source, the AST is kept to size the dead code
+        fs_file_close(fd);
+        cc_free(fd, 0);
+        fd = NULL;
         cc_free(src_base, 0);
         src_base = NULL;
-        cc_free(ast, 0);
-        ast = NULL;
-        cc_free(tsize, 0);
-        tsize = NULL;
 
-        if (src_opt)
+        if (src_opt) {
             disasm_cleanup(&state);
+            printf("\nfolded nodes %6d\npost pass    %6d bytes removed\n", fold_cnt, post_saved);
+            printf("dead code    %6d bytes in %d functions, left out without -s\n", dead_sz,
+                   dead_cnt);
+            for (struct func_s* f = funcs; f; f = f->next)
+                if (!f->id->live)
+                    printf("  %.*s %d\n", f->id->hash & 0x3f, f->id->name, f->size);
+            printf("literal pools %5d, %d branched around\n"
+                   "literals     %6d duplicates shared, %d reused from earlier functions\n",
+                   pool_cnt, pool_jmp, pool_dup, pool_reuse);
+            peep_report();
+        }
 
         // entry point main must be declared
         if (!idmain->val)
@@ -4393,126 +8199,67 @@ int cc(int mode, int argc, char** argv) {
 
         // save the entry point address
         exe.entry = idmain->val;
+        fsym_build();
+        exe_header(&exe);
 
         // optionally create executable output file
-        if (ofn) {
-            // allocate output file descriptor and create the file
-            fd = cc_malloc(sizeof(lfs_file_t), 1, 1);
-            char* cp = full_path(ofn);
-            if (fs_file_open(fd, cp, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) < LFS_ERR_OK) {
-                cc_free(fd, 0);
-                fd = NULL;
-                fatal("could not create %s\n", full_path(ofn));
-            }
-            // initialize the header and write it
-            exe.tsize = ((e + 1) - text_base) * sizeof(*e);
-            exe.dsize = data - data_base;
-            exe.ccver = CC_VERSION;
-            exe.nreloc = nrelocs;
-            if (fs_file_write(fd, &exe, sizeof(exe)) != sizeof(exe)) {
-                fs_file_close(fd);
-                fatal("error writing executable file");
-            }
-            // write the code segment
-            if (fs_file_write(fd, text_base, exe.tsize) != exe.tsize) {
-                fs_file_close(fd);
-                fatal("error writing executable file");
-            }
-            // write the data segment
-            if (exe.dsize && (fs_file_write(fd, data_base, exe.dsize) != exe.dsize)) {
-                fs_file_close(fd);
-                fatal("error writing executable file");
-            }
-            // write the external function relocation list
-            while (relocs) {
-                if (fs_file_write(fd, &relocs->addr, sizeof(relocs->addr)) !=
-                    sizeof(relocs->addr)) {
-                    fs_file_close(fd);
-                    fatal("error writing executable file");
-                }
-                struct reloc_s* r = relocs->next;
-                cc_free(relocs, 0);
-                relocs = r;
-            }
-            // done. close the file and set the executable attribute
-            fs_file_close(fd);
-            cc_free(fd, 0);
-            fd = NULL;
-            if (fs_setattr(full_path(ofn), 1, "exe", 4) < LFS_ERR_OK)
-                fatal("unable to set executable attribute");
-            printf(
-                "\ntext size   0x%04x\ndata size   0x%04x\nentry point 0x%04x\nreloc count %6d\n",
-                exe.tsize, exe.dsize, exe.entry - (int)text_base, exe.nreloc);
+        if (ofn && ofn != cache_fn) {
+            if (exe_write(full_path(ofn), &exe))
+                fatal("error writing executable file %s", full_path(ofn));
+            uint32_t us = time_us_32() - t0;
+            printf("\ntext size   0x%04x\ndata size   0x%04x\nbss size    0x%04x\n"
+                   "dead code   0x%04x in %d functions\n"
+                   "entry point 0x%04x\nreloc count %6d in %d bytes\n",
+                   exe.tsize, exe.dsize, exe.bsize, dead_sz, dead_cnt,
+                   exe.entry - (int)text_base, exe.nreloc, exe.rsize);
+            if (exe.ztsize || exe.zdsize)
+                printf("compressed  0x%04x text, 0x%04x data\n",
+                       exe.ztsize ? exe.ztsize : exe.tsize, exe.zdsize ? exe.zdsize : exe.dsize);
+            printf("compile us  %6d\n", us);
             goto done;
         }
+        cc_free(ast, 0);
+        ast = NULL;
+        cc_free(tsize, 0);
+        tsize = NULL;
         if (src_opt)
             goto done;
+        // save the executable in the cache, trim the segments and resolve its references where
+        // they ended up. The bss moves down to follow the data, into space that is still zero.
+        if (!prof_opt)
+            cache_store(&exe, time_us_32() - t0);
+        seg_trim(exe.tsize, BSS_OFS(&exe) + exe.bsize);
+        for (struct reloc_s* r = relocs; r; r = r->next)
+            exe_reloc(&exe, exe_addr(&exe, r->addr));
+        exe.entry = exe_addr(&exe, exe.entry);
+        t_what = "compile";
     } else { // loader mode
              // output file name is not optional
         if (argc < 1)
             fatal("specify executable file name");
         ofn = argv[0];
-        // check file attribute
-        char buf[4];
-        if (fs_getattr(ofn, 1, buf, sizeof(buf)) != 4)
-            fatal("file %s not found or not executable", ofn);
-        if (memcmp(buf, "exe", 4))
-            fatal("file %s not found or not executable", ofn);
-        // allocate file descriptor and open binary executable file
-        fd = cc_malloc(sizeof(lfs_file_t), 1, 1);
-        if (fs_file_open(fd, ofn, LFS_O_RDONLY) < LFS_ERR_OK)
-            fatal("can't open file %s", ofn);
-        // read the exe header
-        if (fs_file_read(fd, &exe, sizeof(exe)) != sizeof(exe)) {
-            fs_file_close(fd);
-            fatal("error reading %s", ofn);
-        }
-        if (exe.ccver != CC_VERSION)
-            fatal("executable compiled with earlier incompatible version, please recompile");
-        // read in the code segment
-        if (fs_file_read(fd, __StackLimit, exe.tsize) != exe.tsize) {
-            fs_file_close(fd);
-            fd = NULL;
-            fatal("error reading %s", ofn);
-        }
-        // read in the data segment
-        int ds = exe.dsize;
-        if (ds && fs_file_read(fd, __StackLimit + TEXT_BYTES, ds) != ds) {
-            fs_file_close(fd);
-            fd = NULL;
-            fatal("error reading %s", ofn);
-        }
-        // set all the relocatable external function calls
-        for (int i = 0; i < exe.nreloc; i++) {
-            int addr;
-            if (fs_file_read(fd, &addr, sizeof(addr)) != sizeof(addr)) {
-                fs_file_close(fd);
-                fd = NULL;
-                fatal("error reading %s", ofn);
-            }
-            int v = *((int*)addr);
-            if (v < 0) {
-#if PICO_RP2040
-                *((int*)addr) = (int)fops[-v];
-#endif
-            } else {
-                if (IS_PRINTF(&externs[v]))
-                    *((int*)addr) = (int)x_printf;
-                else if (IS_SPRINTF(&externs[v]))
-                    *((int*)addr) = (int)x_sprintf;
-                else
-                    *((int*)addr) = (int)externs[v].extrn;
-            }
-        }
-        // close the file and free its descriptor
-        fs_file_close(fd);
-        cc_free(fd, 1);
-        fd = NULL;
+        exe_load(&exe);
     }
+run:
+    compiling = 0;
     cc_free_all();
+    if (prof_opt) {
+        prof_stk = malloc(PROF_DEPTH * sizeof(struct prof_frame_s));
+        if (!prof_stk)
+            fatal("out of memory");
+#if PICO_RP2350
+        m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+        m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#endif
+    }
+    if (sample_on)
+        sample_start();
 
     // launch the user code
+    if (time_on)
+        printf("\n%s us %9d", t_what, time_us_32() - t_start);
     printf("\n");
+    t_start = time_us_32();
     asm volatile("mov  %0, sp \n" : "=r"(exit_sp));
     asm volatile("mov  r0, %2 \n"
                  "push {r0}   \n"
@@ -4523,9 +8270,22 @@ int cc(int mode, int argc, char** argv) {
                  "mov  %0, r0 \n"
                  : "=r"(rslt)
                  : "r"(exe.entry | 1), "r"(argc), "r"(argv)
-                 : "r0", "r1", "r2", "r3");
+#if PICO_RP2350
+                 : "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r11");
+#else
+                 : "r0", "r1", "r2", "r3", "r4", "r5", "r6");
+#endif
+    sample_stop();
+    while (prof_sp) // functions left through exit()
+        prof_leave();
     // display the return code
     printf("\nCC = %d\n", rslt);
+    if (time_on)
+        printf("run us %10d\n", time_us_32() - t_start);
+    if (prof_opt)
+        prof_report();
+    if (sample_on)
+        sample_report(exe.tsize);
 
 done: // clean up and return
     if (fd)
@@ -4540,6 +8300,14 @@ done: // clean up and return
     }
     // unfreed memory
     cc_free_all();
+    sample_free();
+    seg_free();
+    prof_free();
 
+    if (heap_short) { // compile again with the larger reserve
+        retry = 1;
+        goto restart;
+    }
+    heap_reserve = 0;
     return rslt;
 }
@@ -16,6 +16,7 @@ int cc(int mode, int argc, char* argv[]);
 #define UDATA __attribute__((section(".ccudata")))
 
 __attribute__((__noreturn__)) void run_fatal(const char* fmt, ...);
+__attribute__((__noreturn__)) void cc_heap_short(void); // out of heap, a compile is retried
 __attribute__((__noreturn__)) void fatal_func(const char* func, int lne, const char* fmt, ...);
 
 // fatal erro message and exit
@@ -23,5 +24,6 @@ __attribute__((__noreturn__)) void fatal_func(const char* func, int lne, const c
 
 extern uint16_t* e;
 extern const uint16_t* text_base;
-extern const uint32_t prog_space;
-extern const uint32_t data_space;
+void cc_space(int* text, int* data); // code and data space a compile gets from the free heap
+void cc_sample(int on);              // sample the program counter of the programs run
+void cc_time(int on);                // report the load, compile and run times of the programs run
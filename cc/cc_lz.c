@@ -0,0 +1,76 @@
+#include <string.h>
+
+#include "cc_lz.h"
+
+// compress the n bytes at s into the LZ_BOUND(n) bytes at d, using LZ_WORK bytes at work.
+// Returns the size.
+int lz_pack(const uint8_t* s, int n, uint8_t* d, int* work) {
+    int* last = work;
+    memset(last, 0xff, LZ_WORK); // no earlier position
+    uint8_t* o = d;
+    int i = 0, lit = 0;
+    while (i < n) {
+        int len = 0, dist = 0;
+        if (i + LZ_MIN <= n) {
+            uint32_t h = ((s[i] | s[i + 1] << 8 | s[i + 2] << 16) * 2654435761u) >> (32 - LZ_BITS);
+            int j = last[h];
+            last[h] = i;
+            if (j >= 0 && i - j <= LZ_DIST) {
+                while (len < LZ_MAX && i + len < n && s[j + len] == s[i + len])
+                    ++len;
+                dist = i - j;
+            }
+        }
+        if (len < LZ_MIN) {
+            if (++i - lit < LZ_LIT)
+                continue;
+            len = 0;
+        }
+        // flush the pending literals
+        if (i > lit) {
+            *o++ = i - lit - 1;
+            memcpy(o, s + lit, i - lit);
+            o += i - lit;
+        }
+        if (len) {
+            *o++ = 0x80 | (len - LZ_MIN);
+            *o++ = dist;
+            *o++ = dist >> 8;
+            i += len;
+        }
+        lit = i;
+    }
+    if (i > lit) {
+        *o++ = i - lit - 1;
+        memcpy(o, s + lit, i - lit);
+        o += i - lit;
+    }
+    return o - d;
+}
+
+// expand the n compressed bytes at s into the size bytes at d. Returns 0, or -1 if the input
+// is corrupted.
+int lz_unpack(uint8_t* d, int size, const uint8_t* s, int n) {
+    uint8_t* de = d + size;
+    const uint8_t* se = s + n;
+    while (s < se) {
+        int c = *s++;
+        if (c < 0x80) {
+            if (d + c + 1 > de || s + c + 1 > se)
+                return -1;
+            memcpy(d, s, c + 1);
+            d += c + 1;
+            s += c + 1;
+        } else {
+            if (s + 2 > se)
+                return -1;
+            int dist = s[0] | s[1] << 8, len = (c & 0x7f) + LZ_MIN;
+            s += 2;
+            if (dist == 0 || d + len > de || d - dist < de - size)
+                return -1;
+            for (; len; len--, d++)
+                *d = d[-dist];
+        }
+    }
+    return d == de ? 0 : -1;
+}
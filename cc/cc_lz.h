@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Executables saved with -z store their code and data segments compressed, as a sequence of
+ * tokens. A token byte below 0x80 is followed by that many plus one literal bytes. Otherwise it
+ * copies (token & 0x7f) + LZ_MIN bytes from a 16 bit little endian distance back in the output,
+ * and the copy may overlap itself, so a run of zeroed globals takes 3 bytes per LZ_MAX. A copy
+ * saves at least the literal token it may cost, so the output never grows past a token per
+ * LZ_LIT bytes.
+ */
+
+#define LZ_MIN 4                           // shortest copy
+#define LZ_MAX 131                         // longest copy
+#define LZ_BITS 11                         // match finder hash table size, log2
+#define LZ_LIT 128                         // longest literal run
+#define LZ_DIST 0xffff                     // longest copy distance
+#define LZ_WORK (sizeof(int) << LZ_BITS)   // lz_pack work area bytes
+#define LZ_BOUND(n) ((n) + (n) / LZ_LIT + 1) // lz_pack output bytes for n input bytes
+
+int lz_pack(const uint8_t* s, int n, uint8_t* d, int* work);
+int lz_unpack(uint8_t* d, int size, const uint8_t* s, int n);
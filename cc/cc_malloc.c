@@ -15,13 +15,30 @@ typedef struct qentry_s {
 #define UDATA __attribute__((section(".ccudata")))
 
 static qentry_t malloc_list UDATA; // list of allocated memory blocks
+static char* heap_limit;           // heap top when lowered, or NULL
+
+// heap growth for malloc, held under heap_limit while a program keeps its data above it
+void* _sbrk(int incr) {
+    extern char end, __StackLimit;
+    static char* brk;
+    if (!brk)
+        brk = &end;
+    if (brk + incr > (heap_limit ? heap_limit : &__StackLimit))
+        return (void*)-1;
+    char* prev = brk;
+    brk += incr;
+    return prev;
+}
+
+// lower the heap top to limit, NULL restores it
+void cc_heap_limit(char* limit) { heap_limit = limit; }
 
 // local memory management functions
 void* cc_malloc(int l, int cc, int zero) {
     qentry_t* p = malloc(l + sizeof(qentry_t));
     if (!p) {
         if (cc)
-            run_fatal("out of memory");
+            cc_heap_short();
         else
             return 0;
     }
@@ -3,3 +3,4 @@
 void* cc_malloc(int nbytes, int user, int zero);
 void cc_free(void* m, int user);
 void cc_free_all(void);
+void cc_heap_limit(char* limit);
@@ -1,5 +1,6 @@
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "cc.h"
 #include "cc_peep.h"
@@ -122,7 +123,7 @@ static const uint16_t rep12[] = {0x6838};
 // vmov    s14,r1
 
 static const uint16_t pat13[] = {0x6800, 0xbc02, 0xee07, 0x0a90, 0xee07, 0x1a10};
-static const uint16_t msk13[] = {0xff83, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff};
+static const uint16_t msk13[] = {0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff};
 static const uint16_t rep13[] = {0xedd0, 0x7a00, 0xecbd, 0x7a01};
 
 // pop {r1}             vmov s15,r0
@@ -137,7 +138,7 @@ static const uint16_t rep14[] = {0xee07, 0x0a90, 0xecbd, 0x7a01};
 // vmov s15,r0
 
 static const uint16_t pat15[] = {0x6800, 0xee07, 0x0a90};
-static const uint16_t msk15[] = {0xff83, 0xffff, 0xffff};
+static const uint16_t msk15[] = {0xffff, 0xffff, 0xffff};
 static const uint16_t rep15[] = {0xedd0, 0x7a00};
 
 // vmov r0,s15          vmov r0,s15
@@ -228,7 +229,11 @@ static const struct segs {
 #endif
 };
 
-void peep(void);
+// segments whose last pattern halfword can have a given high byte, one bit per segment
+static uint32_t lookup[256] UDATA;
+static int hits[NUMOF(segments)] UDATA; // replacements made per segment
+
+_Static_assert(NUMOF(segments) <= 32, "peep hole index holds 32 segments");
 
 static void peep_hole(const struct segs* s) {
     uint16_t rslt[8], final[8];
@@ -241,6 +246,13 @@ static void peep_hole(const struct segs* s) {
             return;
         rslt[i] = pe[i] & ~s->msk[i];
     }
+#if PICO_RP2350
+    for (const uint16_t* q = pe - 4; q <= e; ++q) // leave IT blocks alone
+        if (q >= text_base && (*q & 0xff00) == 0xbf00 && (*q & 0xf) &&
+            q + 4 - __builtin_ctz(*q & 0xf) >= pe)
+            return;
+#endif
+    ++hits[s - segments];
     e -= l;
     l = s->n_reps;
     for (int i = 0; i < l; i++)
@@ -253,7 +265,31 @@ static void peep_hole(const struct segs* s) {
     }
 }
 
+void peep_init(void) {
+    for (int i = 0; i < NUMOF(segments); ++i) {
+        const struct segs* s = &segments[i];
+        int m = s->msk[s->n_pats - 1] >> 8, v = s->pat[s->n_pats - 1] >> 8;
+        for (int b = 0; b < 256; b++)
+            if ((b & m) == (v & m))
+                lookup[b] |= 1u << i;
+    }
+}
+
+// try the segments in table order, skipping those that can't match the last halfword
 void peep(void) {
-    for (int i = 0; i < NUMOF(segments); ++i)
+    if (e < text_base)
+        return;
+    for (int i = 0; i < NUMOF(segments); ++i) {
+        uint32_t m = lookup[*e >> 8] >> i; // a replacement changes the last halfword
+        if (!m)
+            return;
+        i += __builtin_ctz(m);
         peep_hole(&segments[i]);
+    }
+}
+
+void peep_report(void) {
+    printf("\npeep hole replacements\n");
+    for (int i = 0; i < NUMOF(segments); ++i)
+        printf("pattern %2d %6d\n", i, hits[i]);
 }
@@ -1,3 +1,5 @@
 #pragma once
 
+void peep_init(void);
 void peep(void);
+void peep_report(void);
@@ -549,8 +549,9 @@ static bool thumb_add_sp_pc_imm(ARMSTATE* state, uint32_t instr) {
         strcpy(state->text, "adr");
     add_it_cond(state, 0);
     padinstr(state->text);
-    uint32_t imm = FIELD(instr, 0, 7);
-    sprintf(tail(state->text), "%s, sp, #%u", register_name(FIELD(instr, 8, 3)), imm);
+    uint32_t imm = 4 * FIELD(instr, 0, 8);
+    sprintf(tail(state->text), "%s, %s, #%u", register_name(FIELD(instr, 8, 3)),
+            BIT_SET(instr, 11) ? "sp" : "pc", imm);
     if (BIT_CLR(instr, 11))
         imm += ALIGN4(state->add_addr +
                       4); /* as it might be a code address, we cannot mark it as a literal pool */
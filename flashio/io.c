@@ -20,6 +20,14 @@
 
 // file system offset in flash
 #define FS_BASE (256 * 1024)
+// executable area size, at the top of flash above the file system. The area is opt in, it
+// shrinks the file system, so an existing one must be reformatted.
+#if PSHELL_XIP_AREA
+#define XIP_BYTES (128 * 1024)
+#else
+#define XIP_BYTES 0
+#endif
+#define XIP_OFS (PICO_FLASH_SIZE_BYTES - XIP_BYTES)
 
 static int fs_hal_read(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer,
                        lfs_size_t size);
@@ -31,7 +39,7 @@ static int fs_hal_erase(const struct lfs_config* c, lfs_block_t block);
 
 static int fs_hal_sync(const struct lfs_config* c);
 
-#define FS_SIZE (PICO_FLASH_SIZE_BYTES - FS_BASE)
+#define FS_SIZE (PICO_FLASH_SIZE_BYTES - FS_BASE - XIP_BYTES)
 
 // configuration of the filesystem is provided by this struct
 // for Pico: prog size = 256, block size = 4096, so cache is 8K
@@ -112,3 +120,32 @@ int fs_fsstat(struct fs_fsstat_t* stat) {
 }
 
 int fs_flash_base(void) { return FS_BASE; }
+
+int fs_xip_size(void) { return XIP_BYTES; }
+
+const void* fs_xip_base(void) { return (const void*)(XIP_BASE + XIP_OFS); }
+
+int fs_xip_erase(int off, int size) {
+    if (off < 0 || off + size > XIP_BYTES || ((off | size) & (FLASH_SECTOR_SIZE - 1)))
+        return LFS_ERR_INVAL;
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(XIP_OFS + off, size);
+    restore_interrupts(ints);
+    return LFS_ERR_OK;
+}
+
+int fs_xip_prog(int off, const void* buf, int size) {
+    if (off < 0 || off + size > XIP_BYTES || (off & (FLASH_PAGE_SIZE - 1)))
+        return LFS_ERR_INVAL;
+    // whole pages, the last one padded
+    uint8_t page[FLASH_PAGE_SIZE];
+    for (int i = 0; i < size; i += FLASH_PAGE_SIZE) {
+        int n = (size - i < FLASH_PAGE_SIZE) ? size - i : FLASH_PAGE_SIZE;
+        memcpy(page, (const uint8_t*)buf + i, n);
+        memset(page + n, 0xff, FLASH_PAGE_SIZE - n);
+        uint32_t ints = save_and_disable_interrupts();
+        flash_range_program(XIP_OFS + off + i, page, FLASH_PAGE_SIZE);
+        restore_interrupts(ints);
+    }
+    return LFS_ERR_OK;
+}
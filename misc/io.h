@@ -131,6 +131,13 @@ static inline lfs_ssize_t fs_fs_size(void) { return lfs_fs_size(&fs_lfs); }
 
 int fs_fsstat(struct fs_fsstat_t* stat);
 
+// executable area, code installed there runs in place. Offsets are from the area start.
+
+int fs_xip_size(void);                               // area size, 0 if there is none
+const void* fs_xip_base(void);                       // area address in the XIP map
+int fs_xip_erase(int off, int size);                 // erase whole sectors
+int fs_xip_prog(int off, const void* buf, int size); // program erased pages
+
 #ifdef __cplusplus
 }
 #endif
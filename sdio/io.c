@@ -116,3 +116,12 @@ int fs_fsstat(struct fs_fsstat_t* stat) {
 #endif
     return LFS_ERR_OK;
 }
+
+// no executable area on the SD card
+int fs_xip_size(void) { return 0; }
+
+const void* fs_xip_base(void) { return NULL; }
+
+int fs_xip_erase(int off, int size) { return LFS_ERR_INVAL; }
+
+int fs_xip_prog(int off, const void* buf, int size) { return LFS_ERR_INVAL; }
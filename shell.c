@@ -683,6 +683,8 @@ static void status_cmd(void) {
                 total_size, stat.blocks_used * 100.0 / stat.block_count, percent);
     } else
         sprintf(result, "Storage - not mounted\n");
+    int prog_space, data_space;
+    cc_space(&prog_space, &data_space);
     sprintf(result + strlen(result),
             "Memory  - heap: %.1fK, program code space: %dK, global data space: %dK\n"
             "Console - %s, width %d, height %d",
@@ -769,6 +771,44 @@ static void cc_cmd(void) {
     cc(0, argc, argv);
 }
 
+static bool run_as_cmd(const char* dir);
+
+// run a command with its program counter sampled, a compile & run or an executable
+static void prof_cmd(void) {
+    if (argc < 2) {
+        strcpy(result, "specify the command to profile");
+        return;
+    }
+    if (check_mount(true))
+        return;
+    --argc;
+    memmove(argv, argv + 1, (argc + 1) * sizeof(argv[0]));
+    cc_sample(true);
+    if (strcmp(argv[0], "cc") == 0)
+        cc(0, argc, argv);
+    else if (!run_as_cmd("") && !run_as_cmd("/bin/"))
+        sprintf(result, "unknown command '%s'", argv[0]);
+    cc_sample(false);
+}
+
+// run a command reporting the time to load or compile the program and to run it
+static void time_cmd(void) {
+    if (argc < 2) {
+        strcpy(result, "specify the command to time");
+        return;
+    }
+    if (check_mount(true))
+        return;
+    --argc;
+    memmove(argv, argv + 1, (argc + 1) * sizeof(argv[0]));
+    cc_time(true);
+    if (strcmp(argv[0], "cc") == 0)
+        cc(0, argc, argv);
+    else if (!run_as_cmd("") && !run_as_cmd("/bin/"))
+        sprintf(result, "unknown command '%s'", argv[0]);
+    cc_time(false);
+}
+
 static void tar_cmd(void) {
     if (check_mount(true))
         return;
@@ -935,11 +975,13 @@ const cmd_t cmd_table[] = {
     {"mount",   mount_cmd,      "mount the filesystem"},
     {"mv",      mv_cmd,         "rename a file or directory"},
     {"news",    news_cmd,       "what's new in this release"},
+    {"prof",    prof_cmd,       "sample where a program spends its time"},
     {"quit",    quit_cmd,       "shutdown the system"},
     {"reboot",  reboot_cmd,     "restart the system"},
     {"rm",      rm_cmd,         "remove a file or directory. -r for recursive"},
     {"status",  status_cmd,     "display the filesystem status"},
     {"tar",     tar_cmd,        "manage tar archives"},
+    {"time",    time_cmd,       "time loading and running a program"},
 #if !defined(NDEBUG) || defined(PSHELL_TESTS)
     {"tests",   tests_cmd,      "run all tests"},
     {"trim",    trim_cmd,       "filesystem garbage collection"},
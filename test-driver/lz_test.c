@@ -0,0 +1,129 @@
+/* Host round trip test of the cc -z executable compression. Build and run it with
+ *
+ *   cc -O2 -Wall -I../cc -o lz_test lz_test.c ../cc/cc_lz.c && ./lz_test
+ *
+ * from this directory. It prints one line per case and exits non zero if any fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc_lz.h"
+
+static int work[LZ_WORK / sizeof(int)];
+static int failed;
+
+// check the compressed stream parses and its copies are in range. Returns -1 if not, else
+// whether it has a copy of len bytes from dist back, either of which may be 0 for any.
+static int lz_check(const uint8_t* z, int zn, int len, int dist) {
+    int found = 0;
+    for (int i = 0; i < zn;) {
+        int c = z[i++];
+        if (c < 0x80) {
+            i += c + 1;
+        } else {
+            if (i + 2 > zn)
+                return -1;
+            int l = (c & 0x7f) + LZ_MIN, d = z[i] | z[i + 1] << 8;
+            i += 2;
+            if (d == 0 || d > LZ_DIST)
+                return -1;
+            if ((!len || l == len) && (!dist || d == dist))
+                found = 1;
+        }
+        if (i > zn)
+            return -1;
+    }
+    return found;
+}
+
+// compress and expand the n bytes at s. If len or dist isn't 0 the compressed stream must
+// have a copy of that length or distance.
+static void round_trip(const char* name, const uint8_t* s, int n, int len, int dist) {
+    uint8_t* z = malloc(LZ_BOUND(n));
+    uint8_t* d = malloc(n + 1);
+    const char* err = NULL;
+    int zn = lz_pack(s, n, z, work);
+    int found = lz_check(z, zn, len, dist);
+    d[n] = 0x5a; // guard
+    if (zn > LZ_BOUND(n))
+        err = "output past LZ_BOUND";
+    else if (lz_unpack(d, n, z, zn))
+        err = "lz_unpack failed";
+    else if (memcmp(d, s, n))
+        err = "output differs";
+    else if (d[n] != 0x5a)
+        err = "wrote past the end";
+    else if (found < 0)
+        err = "bad token stream";
+    else if ((len || dist) && !found)
+        err = "expected copy not used";
+    else if (n && lz_unpack(d, n - 1, z, zn) == 0)
+        err = "short output not detected";
+    else if (zn && lz_unpack(d, n, z, zn - 1) == 0)
+        err = "short input not detected";
+    printf("%-32s %7d -> %7d  %s\n", name, n, zn, err ? err : "ok");
+    if (err)
+        failed = 1;
+    free(d);
+    free(z);
+}
+
+// fill n bytes with a pseudo random sequence, which doesn't compress
+static void noise(uint8_t* s, int n, uint32_t seed) {
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        s[i] = seed >> 24;
+    }
+}
+
+int main(void) {
+    static uint8_t s[0x30000];
+
+    round_trip("empty", s, 0, 0, 0);
+    s[0] = 1;
+    round_trip("one byte", s, 1, 0, 0);
+
+    noise(s, LZ_LIT, 1);
+    round_trip("one literal run", s, LZ_LIT, 0, 0);
+    noise(s, LZ_LIT + 1, 2);
+    round_trip("literal run plus one", s, LZ_LIT + 1, 0, 0);
+    noise(s, 0x10000, 3);
+    round_trip("incompressible", s, 0x10000, 0, 0);
+
+    memset(s, 0, LZ_MAX + 1);
+    round_trip("zeros, max copy", s, LZ_MAX + 1, LZ_MAX, 1);
+    memset(s, 0, 10000);
+    round_trip("zeros, many max copies", s, 10000, LZ_MAX, 0);
+    noise(s, 8, 4);
+    memcpy(s + 8, s, 8);
+    round_trip("shortest input with a copy", s, 8 + LZ_MIN, LZ_MIN, 8);
+    for (int i = 0; i < 1000; i++)
+        s[i] = "abc"[i % 3];
+    round_trip("overlapping copies", s, 1000, LZ_MAX, 0);
+
+    // a 32 byte block repeated exactly at the longest distance, then one byte past it. The zeros
+    // between them keep the match finder from forgetting the first copy.
+    memset(s, 0, 0x20000);
+    noise(s, 32, 5);
+    memcpy(s + LZ_DIST, s, 32);
+    round_trip("copy at the longest distance", s, LZ_DIST + 32, 32, LZ_DIST);
+    memset(s + LZ_DIST, 0, 32);
+    memcpy(s + LZ_DIST + 1, s, 32);
+    round_trip("copy past the longest distance", s, LZ_DIST + 1 + 32, LZ_MAX, 0);
+
+    // a mix of text like runs and noise across a large input
+    const char* text = "int main() { printf(\"%d\\n\", 42); return 0; }\n";
+    for (int i = 0; i < (int)sizeof(s); i += 64) {
+        if ((i / 64) % 3)
+            noise(s + i, 64, i);
+        else
+            for (int j = 0; j < 64; j++)
+                s[i + j] = text[j % strlen(text)];
+    }
+    round_trip("mixed", s, sizeof(s), 0, 0);
+
+    printf(failed ? "FAILED\n" : "PASSED\n");
+    return failed;
+}
@@ -0,0 +1,14 @@
+// cc rejects this program: the case labels 2 and 1 + 1 are the same
+int main() {
+    int x;
+    x = 2;
+    switch (x) {
+    case 1:
+        return 1;
+    case 2:
+        return 0;
+    case 1 + 1:
+        return 2;
+    }
+    return 3;
+}
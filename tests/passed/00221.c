@@ -0,0 +1,27 @@
+#include <stdio.h>
+
+int buf[8];
+char text[6];
+
+int main() {
+    int* p;
+    char* c;
+    int n;
+
+    n = 0;
+    for (p = buf; p < buf + 8; ++p)
+        *p = n++;
+    n = 0;
+    for (p = buf; p < &buf[8]; ++p)
+        n += *p;
+    printf("%d\n", n);
+    n = 0;
+    for (p = buf + 8; p > buf; --p)
+        ++n;
+    printf("%d\n", n);
+    for (c = text; c < text + 5; ++c)
+        *c = 'a' + (c - text);
+    *c = 0;
+    printf("%s\n", text);
+    return 0;
+}
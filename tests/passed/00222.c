@@ -0,0 +1,87 @@
+#include <stdio.h>
+
+int vals[] = {0, 1, -1, 6, -6, 7, -7, 9, -9, 10, -10, 99, -99, 640, 641, -641, 642, -642,
+              1000000, -1000000, 2147483647, -2147483647, -2147483647 - 1};
+
+int by_const(int x) {
+    printf("%d:", x);
+    printf(" %d %d", x / 1, x % 1);
+    printf(" %d %d", x / 2, x % 2);
+    printf(" %d %d", x / -2, x % -2);
+    printf(" %d %d", x / 8, x % 8);
+    printf(" %d %d", x / -8, x % -8);
+    printf(" %d %d", x / 65536, x % 65536);
+    printf(" %d %d", x / 7, x % 7);
+    printf(" %d %d", x / -7, x % -7);
+    printf(" %d %d", x / 10, x % 10);
+    printf(" %d %d", x / -10, x % -10);
+    printf(" %d %d", x / 641, x % 641);
+    printf(" %d %d", x / 1000000007, x % 1000000007);
+    printf(" %d %d", x / (-2147483647 - 1), x % (-2147483647 - 1));
+    printf("\n");
+    return 0;
+}
+
+// divisor -1 leaves out INT_MIN, whose quotient overflows
+int by_minus_one(int x) {
+    printf("%d: %d %d\n", x, x / -1, x % -1);
+    return 0;
+}
+
+// the quotient and remainder of the same division, in either order, computed once
+int divmod(int x) {
+    int q, r, q2, r2;
+    q = x / 10;
+    r = x % 10;
+    r2 = x % 7;
+    q2 = x / 7;
+    printf("%d: %d %d %d %d\n", x, q, r, q2, r2);
+    return q * 10 + r - x + q2 * 7 + r2 - x;
+}
+
+// the second statement divides the new value, so the pair can't share a division
+int divmod_chain(int x) {
+    int r;
+    x = x / 10;
+    r = x % 10;
+    return x * 100 + r;
+}
+
+// compound assignments by constants
+int compound(int x) {
+    int y;
+    y = x;
+    x /= 10;
+    y %= -641;
+    return x + y;
+}
+
+// decimal digits of x, most significant first
+int digits(int x) {
+    char buf[16];
+    int i, d;
+    i = 15;
+    buf[i] = 0;
+    do {
+        d = x % 10;
+        x = x / 10;
+        buf[--i] = '0' + (d < 0 ? -d : d);
+    } while (x);
+    printf("%s\n", buf + i);
+    return 0;
+}
+
+int main() {
+    int i, n, bad;
+    n = sizeof(vals) / sizeof(vals[0]);
+    bad = 0;
+    for (i = 0; i < n; i++) {
+        by_const(vals[i]);
+        if (vals[i] != -2147483647 - 1)
+            by_minus_one(vals[i]);
+        bad = bad + divmod(vals[i]);
+        printf("%d %d\n", divmod_chain(vals[i]), compound(vals[i]));
+        digits(vals[i]);
+    }
+    return bad;
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+
+int ys[] = {-1, 0, 1, 2, 3, 4, 100, 10000};
+int ss[] = {-2147483647 - 1, -2147483647, -1000000, -101, -100, -99, 0, 1, 2, 10,
+            999, 1000, 65535, 65536, 1000000, 2147483646, 2147483647};
+
+// dense labels, a jump table
+int dense(int x) {
+    switch (x) {
+    case 0:
+        return 10;
+    case 1:
+        return 11;
+    case 2:
+        return 12;
+    case 3:
+        return 13;
+    case 5:
+        return 15;
+    case 6:
+        return 16;
+    case 7:
+        return 17;
+    }
+    return -1;
+}
+
+// labels too far apart for a table, a binary search
+int sparse(int x) {
+    switch (x) {
+    case -2147483647 - 1:
+        return 1;
+    case -1000000:
+        return 2;
+    case -100:
+        return 3;
+    case 1:
+        return 4;
+    case 10:
+        return 5;
+    case 1000:
+        return 6;
+    case 65536:
+        return 7;
+    case 1000000:
+        return 8;
+    case 2147483647:
+        return 9;
+    default:
+        return 0;
+    }
+}
+
+// a dense run of negative labels, default first
+int negative(int x) {
+    int r;
+    r = 0;
+    switch (x) {
+    default:
+        r = 100;
+        break;
+    case -6:
+        r = 6;
+        break;
+    case -5:
+        r = 5;
+        break;
+    case -4:
+        r = 4;
+        break;
+    case -3:
+        r = 3;
+        break;
+    case -1:
+        r = 1;
+        break;
+    case 0:
+        r = 99;
+        break;
+    }
+    return r;
+}
+
+// default between the cases, and cases falling through
+int fallthrough(int x) {
+    int r;
+    r = 0;
+    switch (x) {
+    case 1:
+        r += 1;
+    case 2:
+        r += 2;
+    default:
+        r += 100;
+    case 3:
+        r += 3;
+        break;
+    case 4:
+        r += 4;
+    case 5:
+        r += 5;
+    }
+    return r;
+}
+
+// a switch in a case of a jump table switch
+int nested(int x, int y) {
+    switch (x) {
+    case 0:
+        return 0;
+    case 1:
+        switch (y) {
+        case 1:
+            return 11;
+        case 100:
+            return 1100;
+        case 10000:
+            return 110000;
+        default:
+            return 1;
+        }
+    case 2:
+        switch (y) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            return 20 + y;
+        }
+        return 2;
+    case 3:
+        return 3;
+    case 4:
+        break;
+    }
+    return -1;
+}
+
+// character labels, and a switch with only a default
+int chars(char* s) {
+    int n;
+    n = 0;
+    for (; *s; s++) {
+        switch (*s) {
+        case 'a':
+        case 'e':
+        case 'i':
+        case 'o':
+        case 'u':
+            n += 1;
+            break;
+        case ' ':
+            n += 100;
+            continue;
+        }
+        switch (*s) {
+        default:
+            n += 1000;
+        }
+    }
+    return n;
+}
+
+int main() {
+    int i, j;
+    for (i = -3; i < 10; i++)
+        printf("dense %d %d\n", i, dense(i));
+    for (i = 0; i < sizeof(ss) / sizeof(ss[0]); i++)
+        printf("sparse %d %d\n", ss[i], sparse(ss[i]));
+    for (i = -8; i < 3; i++)
+        printf("negative %d %d\n", i, negative(i));
+    for (i = 0; i < 7; i++)
+        printf("fallthrough %d %d\n", i, fallthrough(i));
+    for (i = -1; i < 6; i++)
+        for (j = 0; j < sizeof(ys) / sizeof(ys[0]); j++)
+            printf("nested %d %d %d\n", i, ys[j], nested(i, ys[j]));
+    printf("chars %d\n", chars("a quick brown fox"));
+    return 0;
+}
@@ -0,0 +1,717 @@
+#include <stdio.h>
+
+int vals[] = {-2147483647 - 1, -2147483647, -257, -256, -1, 0, 1, 254, 255, 256, 257,
+              2147483646, 2147483647};
+
+// each comparison against y, as a branch and as a value, packed into the bits of the result
+int cmp(int x, int y) {
+    int r;
+    r = 0;
+    if (x == y)
+        r |= 1;
+    if (x != y)
+        r |= 2;
+    if (x < y)
+        r |= 4;
+    if (x <= y)
+        r |= 8;
+    if (x > y)
+        r |= 16;
+    if (x >= y)
+        r |= 32;
+    r |= (x < y ? 1 : 0) << 6;
+    r |= (x >= y ? 1 : 0) << 7;
+    r |= (x > y ? y : x) == x ? 256 : 0;
+    return r;
+}
+
+// the same against constants, the small ones take cmp rk,#n
+int cmp_const(int x) {
+    int r;
+    r = 0;
+    if (x < 0)
+        r |= 1;
+    if (x <= 0)
+        r |= 2;
+    if (x > 255)
+        r |= 4;
+    if (x >= 255)
+        r |= 8;
+    if (x < 256)
+        r |= 16;
+    if (x > -1)
+        r |= 32;
+    if (x == 255)
+        r |= 64;
+    if (x != -2147483647 - 1)
+        r |= 128;
+    if (x > 2147483646)
+        r |= 256;
+    r |= (x < 0 ? 1 : 0) << 9;
+    r |= (x > 255 ? 1 : 0) << 10;
+    return r;
+}
+
+// float comparisons, which are all false but != when either side is a NaN
+int cmpf(float x, float y) {
+    int r;
+    r = 0;
+    if (x == y)
+        r |= 1;
+    if (x != y)
+        r |= 2;
+    if (x < y)
+        r |= 4;
+    if (x <= y)
+        r |= 8;
+    if (x > y)
+        r |= 16;
+    if (x >= y)
+        r |= 32;
+    r |= (x < y ? 1 : 0) << 6;
+    r |= (x <= y ? 1 : 0) << 7;
+    r |= (x > y ? 1 : 0) << 8;
+    r |= (x >= y ? 1 : 0) << 9;
+    r |= (x == y ? 1 : 0) << 10;
+    r |= (x != y ? 1 : 0) << 11;
+    return r;
+}
+
+// a loop body too long for the short forms of the conditional branch back to its start
+int long_loop(int n) {
+    int i, x;
+    x = 0;
+    for (i = 0; i < n; i++) {
+        x = x * 33 + i + 0;
+        x = x * 33 + i + 1;
+        x = x * 33 + i + 2;
+        x = x * 33 + i + 3;
+        x = x * 33 + i + 4;
+        x = x * 33 + i + 5;
+        x = x * 33 + i + 6;
+        x = x * 33 + i + 7;
+        x = x * 33 + i + 8;
+        x = x * 33 + i + 9;
+        x = x * 33 + i + 10;
+        x = x * 33 + i + 11;
+        x = x * 33 + i + 12;
+        x = x * 33 + i + 13;
+        x = x * 33 + i + 14;
+        x = x * 33 + i + 15;
+        x = x * 33 + i + 16;
+        x = x * 33 + i + 17;
+        x = x * 33 + i + 18;
+        x = x * 33 + i + 19;
+        x = x * 33 + i + 20;
+        x = x * 33 + i + 21;
+        x = x * 33 + i + 22;
+        x = x * 33 + i + 23;
+        x = x * 33 + i + 24;
+        x = x * 33 + i + 25;
+        x = x * 33 + i + 26;
+        x = x * 33 + i + 27;
+        x = x * 33 + i + 28;
+        x = x * 33 + i + 29;
+        x = x * 33 + i + 30;
+        x = x * 33 + i + 31;
+        x = x * 33 + i + 32;
+        x = x * 33 + i + 33;
+        x = x * 33 + i + 34;
+        x = x * 33 + i + 35;
+        x = x * 33 + i + 36;
+        x = x * 33 + i + 37;
+        x = x * 33 + i + 38;
+        x = x * 33 + i + 39;
+        x = x * 33 + i + 40;
+        x = x * 33 + i + 41;
+        x = x * 33 + i + 42;
+        x = x * 33 + i + 43;
+        x = x * 33 + i + 44;
+        x = x * 33 + i + 45;
+        x = x * 33 + i + 46;
+        x = x * 33 + i + 47;
+        x = x * 33 + i + 48;
+        x = x * 33 + i + 49;
+        x = x * 33 + i + 50;
+        x = x * 33 + i + 51;
+        x = x * 33 + i + 52;
+        x = x * 33 + i + 53;
+        x = x * 33 + i + 54;
+        x = x * 33 + i + 55;
+        x = x * 33 + i + 56;
+        x = x * 33 + i + 57;
+        x = x * 33 + i + 58;
+        x = x * 33 + i + 59;
+        x = x * 33 + i + 60;
+        x = x * 33 + i + 61;
+        x = x * 33 + i + 62;
+        x = x * 33 + i + 63;
+        x = x * 33 + i + 64;
+        x = x * 33 + i + 65;
+        x = x * 33 + i + 66;
+        x = x * 33 + i + 67;
+        x = x * 33 + i + 68;
+        x = x * 33 + i + 69;
+        x = x * 33 + i + 70;
+        x = x * 33 + i + 71;
+        x = x * 33 + i + 72;
+        x = x * 33 + i + 73;
+        x = x * 33 + i + 74;
+        x = x * 33 + i + 75;
+        x = x * 33 + i + 76;
+        x = x * 33 + i + 77;
+        x = x * 33 + i + 78;
+        x = x * 33 + i + 79;
+        x = x * 33 + i + 80;
+        x = x * 33 + i + 81;
+        x = x * 33 + i + 82;
+        x = x * 33 + i + 83;
+        x = x * 33 + i + 84;
+        x = x * 33 + i + 85;
+        x = x * 33 + i + 86;
+        x = x * 33 + i + 87;
+        x = x * 33 + i + 88;
+        x = x * 33 + i + 89;
+        x = x * 33 + i + 90;
+        x = x * 33 + i + 91;
+        x = x * 33 + i + 92;
+        x = x * 33 + i + 93;
+        x = x * 33 + i + 94;
+        x = x * 33 + i + 95;
+        x = x * 33 + i + 96;
+        x = x * 33 + i + 97;
+        x = x * 33 + i + 98;
+        x = x * 33 + i + 99;
+        x = x * 33 + i + 100;
+        x = x * 33 + i + 101;
+        x = x * 33 + i + 102;
+        x = x * 33 + i + 103;
+        x = x * 33 + i + 104;
+        x = x * 33 + i + 105;
+        x = x * 33 + i + 106;
+        x = x * 33 + i + 107;
+        x = x * 33 + i + 108;
+        x = x * 33 + i + 109;
+        x = x * 33 + i + 110;
+        x = x * 33 + i + 111;
+        x = x * 33 + i + 112;
+        x = x * 33 + i + 113;
+        x = x * 33 + i + 114;
+        x = x * 33 + i + 115;
+        x = x * 33 + i + 116;
+        x = x * 33 + i + 117;
+        x = x * 33 + i + 118;
+        x = x * 33 + i + 119;
+        x = x * 33 + i + 120;
+        x = x * 33 + i + 121;
+        x = x * 33 + i + 122;
+        x = x * 33 + i + 123;
+        x = x * 33 + i + 124;
+        x = x * 33 + i + 125;
+        x = x * 33 + i + 126;
+        x = x * 33 + i + 127;
+        x = x * 33 + i + 128;
+        x = x * 33 + i + 129;
+        x = x * 33 + i + 130;
+        x = x * 33 + i + 131;
+        x = x * 33 + i + 132;
+        x = x * 33 + i + 133;
+        x = x * 33 + i + 134;
+        x = x * 33 + i + 135;
+        x = x * 33 + i + 136;
+        x = x * 33 + i + 137;
+        x = x * 33 + i + 138;
+        x = x * 33 + i + 139;
+        x = x * 33 + i + 140;
+        x = x * 33 + i + 141;
+        x = x * 33 + i + 142;
+        x = x * 33 + i + 143;
+        x = x * 33 + i + 144;
+        x = x * 33 + i + 145;
+        x = x * 33 + i + 146;
+        x = x * 33 + i + 147;
+        x = x * 33 + i + 148;
+        x = x * 33 + i + 149;
+        x = x * 33 + i + 150;
+        x = x * 33 + i + 151;
+        x = x * 33 + i + 152;
+        x = x * 33 + i + 153;
+        x = x * 33 + i + 154;
+        x = x * 33 + i + 155;
+        x = x * 33 + i + 156;
+        x = x * 33 + i + 157;
+        x = x * 33 + i + 158;
+        x = x * 33 + i + 159;
+        x = x * 33 + i + 160;
+        x = x * 33 + i + 161;
+        x = x * 33 + i + 162;
+        x = x * 33 + i + 163;
+        x = x * 33 + i + 164;
+        x = x * 33 + i + 165;
+        x = x * 33 + i + 166;
+        x = x * 33 + i + 167;
+        x = x * 33 + i + 168;
+        x = x * 33 + i + 169;
+        x = x * 33 + i + 170;
+        x = x * 33 + i + 171;
+        x = x * 33 + i + 172;
+        x = x * 33 + i + 173;
+        x = x * 33 + i + 174;
+        x = x * 33 + i + 175;
+        x = x * 33 + i + 176;
+        x = x * 33 + i + 177;
+        x = x * 33 + i + 178;
+        x = x * 33 + i + 179;
+        x = x * 33 + i + 180;
+        x = x * 33 + i + 181;
+        x = x * 33 + i + 182;
+        x = x * 33 + i + 183;
+        x = x * 33 + i + 184;
+        x = x * 33 + i + 185;
+        x = x * 33 + i + 186;
+        x = x * 33 + i + 187;
+        x = x * 33 + i + 188;
+        x = x * 33 + i + 189;
+        x = x * 33 + i + 190;
+        x = x * 33 + i + 191;
+        x = x * 33 + i + 192;
+        x = x * 33 + i + 193;
+        x = x * 33 + i + 194;
+        x = x * 33 + i + 195;
+        x = x * 33 + i + 196;
+        x = x * 33 + i + 197;
+        x = x * 33 + i + 198;
+        x = x * 33 + i + 199;
+        x = x * 33 + i + 200;
+        x = x * 33 + i + 201;
+        x = x * 33 + i + 202;
+        x = x * 33 + i + 203;
+        x = x * 33 + i + 204;
+        x = x * 33 + i + 205;
+        x = x * 33 + i + 206;
+        x = x * 33 + i + 207;
+        x = x * 33 + i + 208;
+        x = x * 33 + i + 209;
+        x = x * 33 + i + 210;
+        x = x * 33 + i + 211;
+        x = x * 33 + i + 212;
+        x = x * 33 + i + 213;
+        x = x * 33 + i + 214;
+        x = x * 33 + i + 215;
+        x = x * 33 + i + 216;
+        x = x * 33 + i + 217;
+        x = x * 33 + i + 218;
+        x = x * 33 + i + 219;
+        x = x * 33 + i + 220;
+        x = x * 33 + i + 221;
+        x = x * 33 + i + 222;
+        x = x * 33 + i + 223;
+        x = x * 33 + i + 224;
+        x = x * 33 + i + 225;
+        x = x * 33 + i + 226;
+        x = x * 33 + i + 227;
+        x = x * 33 + i + 228;
+        x = x * 33 + i + 229;
+        x = x * 33 + i + 230;
+        x = x * 33 + i + 231;
+        x = x * 33 + i + 232;
+        x = x * 33 + i + 233;
+        x = x * 33 + i + 234;
+        x = x * 33 + i + 235;
+        x = x * 33 + i + 236;
+        x = x * 33 + i + 237;
+        x = x * 33 + i + 238;
+        x = x * 33 + i + 239;
+        x = x * 33 + i + 240;
+        x = x * 33 + i + 241;
+        x = x * 33 + i + 242;
+        x = x * 33 + i + 243;
+        x = x * 33 + i + 244;
+        x = x * 33 + i + 245;
+        x = x * 33 + i + 246;
+        x = x * 33 + i + 247;
+        x = x * 33 + i + 248;
+        x = x * 33 + i + 249;
+        x = x * 33 + i + 250;
+        x = x * 33 + i + 251;
+        x = x * 33 + i + 252;
+        x = x * 33 + i + 253;
+        x = x * 33 + i + 254;
+        x = x * 33 + i + 255;
+        x = x * 33 + i + 256;
+        x = x * 33 + i + 257;
+        x = x * 33 + i + 258;
+        x = x * 33 + i + 259;
+        x = x * 33 + i + 260;
+        x = x * 33 + i + 261;
+        x = x * 33 + i + 262;
+        x = x * 33 + i + 263;
+        x = x * 33 + i + 264;
+        x = x * 33 + i + 265;
+        x = x * 33 + i + 266;
+        x = x * 33 + i + 267;
+        x = x * 33 + i + 268;
+        x = x * 33 + i + 269;
+        x = x * 33 + i + 270;
+        x = x * 33 + i + 271;
+        x = x * 33 + i + 272;
+        x = x * 33 + i + 273;
+        x = x * 33 + i + 274;
+        x = x * 33 + i + 275;
+        x = x * 33 + i + 276;
+        x = x * 33 + i + 277;
+        x = x * 33 + i + 278;
+        x = x * 33 + i + 279;
+        x = x * 33 + i + 280;
+        x = x * 33 + i + 281;
+        x = x * 33 + i + 282;
+        x = x * 33 + i + 283;
+        x = x * 33 + i + 284;
+        x = x * 33 + i + 285;
+        x = x * 33 + i + 286;
+        x = x * 33 + i + 287;
+        x = x * 33 + i + 288;
+        x = x * 33 + i + 289;
+        x = x * 33 + i + 290;
+        x = x * 33 + i + 291;
+        x = x * 33 + i + 292;
+        x = x * 33 + i + 293;
+        x = x * 33 + i + 294;
+        x = x * 33 + i + 295;
+        x = x * 33 + i + 296;
+        x = x * 33 + i + 297;
+        x = x * 33 + i + 298;
+        x = x * 33 + i + 299;
+    }
+    i = 0;
+    do {
+        x = x * 33 + i + 0;
+        x = x * 33 + i + 1;
+        x = x * 33 + i + 2;
+        x = x * 33 + i + 3;
+        x = x * 33 + i + 4;
+        x = x * 33 + i + 5;
+        x = x * 33 + i + 6;
+        x = x * 33 + i + 7;
+        x = x * 33 + i + 8;
+        x = x * 33 + i + 9;
+        x = x * 33 + i + 10;
+        x = x * 33 + i + 11;
+        x = x * 33 + i + 12;
+        x = x * 33 + i + 13;
+        x = x * 33 + i + 14;
+        x = x * 33 + i + 15;
+        x = x * 33 + i + 16;
+        x = x * 33 + i + 17;
+        x = x * 33 + i + 18;
+        x = x * 33 + i + 19;
+        x = x * 33 + i + 20;
+        x = x * 33 + i + 21;
+        x = x * 33 + i + 22;
+        x = x * 33 + i + 23;
+        x = x * 33 + i + 24;
+        x = x * 33 + i + 25;
+        x = x * 33 + i + 26;
+        x = x * 33 + i + 27;
+        x = x * 33 + i + 28;
+        x = x * 33 + i + 29;
+        x = x * 33 + i + 30;
+        x = x * 33 + i + 31;
+        x = x * 33 + i + 32;
+        x = x * 33 + i + 33;
+        x = x * 33 + i + 34;
+        x = x * 33 + i + 35;
+        x = x * 33 + i + 36;
+        x = x * 33 + i + 37;
+        x = x * 33 + i + 38;
+        x = x * 33 + i + 39;
+        x = x * 33 + i + 40;
+        x = x * 33 + i + 41;
+        x = x * 33 + i + 42;
+        x = x * 33 + i + 43;
+        x = x * 33 + i + 44;
+        x = x * 33 + i + 45;
+        x = x * 33 + i + 46;
+        x = x * 33 + i + 47;
+        x = x * 33 + i + 48;
+        x = x * 33 + i + 49;
+        x = x * 33 + i + 50;
+        x = x * 33 + i + 51;
+        x = x * 33 + i + 52;
+        x = x * 33 + i + 53;
+        x = x * 33 + i + 54;
+        x = x * 33 + i + 55;
+        x = x * 33 + i + 56;
+        x = x * 33 + i + 57;
+        x = x * 33 + i + 58;
+        x = x * 33 + i + 59;
+        x = x * 33 + i + 60;
+        x = x * 33 + i + 61;
+        x = x * 33 + i + 62;
+        x = x * 33 + i + 63;
+        x = x * 33 + i + 64;
+        x = x * 33 + i + 65;
+        x = x * 33 + i + 66;
+        x = x * 33 + i + 67;
+        x = x * 33 + i + 68;
+        x = x * 33 + i + 69;
+        x = x * 33 + i + 70;
+        x = x * 33 + i + 71;
+        x = x * 33 + i + 72;
+        x = x * 33 + i + 73;
+        x = x * 33 + i + 74;
+        x = x * 33 + i + 75;
+        x = x * 33 + i + 76;
+        x = x * 33 + i + 77;
+        x = x * 33 + i + 78;
+        x = x * 33 + i + 79;
+        x = x * 33 + i + 80;
+        x = x * 33 + i + 81;
+        x = x * 33 + i + 82;
+        x = x * 33 + i + 83;
+        x = x * 33 + i + 84;
+        x = x * 33 + i + 85;
+        x = x * 33 + i + 86;
+        x = x * 33 + i + 87;
+        x = x * 33 + i + 88;
+        x = x * 33 + i + 89;
+        x = x * 33 + i + 90;
+        x = x * 33 + i + 91;
+        x = x * 33 + i + 92;
+        x = x * 33 + i + 93;
+        x = x * 33 + i + 94;
+        x = x * 33 + i + 95;
+        x = x * 33 + i + 96;
+        x = x * 33 + i + 97;
+        x = x * 33 + i + 98;
+        x = x * 33 + i + 99;
+        x = x * 33 + i + 100;
+        x = x * 33 + i + 101;
+        x = x * 33 + i + 102;
+        x = x * 33 + i + 103;
+        x = x * 33 + i + 104;
+        x = x * 33 + i + 105;
+        x = x * 33 + i + 106;
+        x = x * 33 + i + 107;
+        x = x * 33 + i + 108;
+        x = x * 33 + i + 109;
+        x = x * 33 + i + 110;
+        x = x * 33 + i + 111;
+        x = x * 33 + i + 112;
+        x = x * 33 + i + 113;
+        x = x * 33 + i + 114;
+        x = x * 33 + i + 115;
+        x = x * 33 + i + 116;
+        x = x * 33 + i + 117;
+        x = x * 33 + i + 118;
+        x = x * 33 + i + 119;
+        x = x * 33 + i + 120;
+        x = x * 33 + i + 121;
+        x = x * 33 + i + 122;
+        x = x * 33 + i + 123;
+        x = x * 33 + i + 124;
+        x = x * 33 + i + 125;
+        x = x * 33 + i + 126;
+        x = x * 33 + i + 127;
+        x = x * 33 + i + 128;
+        x = x * 33 + i + 129;
+        x = x * 33 + i + 130;
+        x = x * 33 + i + 131;
+        x = x * 33 + i + 132;
+        x = x * 33 + i + 133;
+        x = x * 33 + i + 134;
+        x = x * 33 + i + 135;
+        x = x * 33 + i + 136;
+        x = x * 33 + i + 137;
+        x = x * 33 + i + 138;
+        x = x * 33 + i + 139;
+        x = x * 33 + i + 140;
+        x = x * 33 + i + 141;
+        x = x * 33 + i + 142;
+        x = x * 33 + i + 143;
+        x = x * 33 + i + 144;
+        x = x * 33 + i + 145;
+        x = x * 33 + i + 146;
+        x = x * 33 + i + 147;
+        x = x * 33 + i + 148;
+        x = x * 33 + i + 149;
+        x = x * 33 + i + 150;
+        x = x * 33 + i + 151;
+        x = x * 33 + i + 152;
+        x = x * 33 + i + 153;
+        x = x * 33 + i + 154;
+        x = x * 33 + i + 155;
+        x = x * 33 + i + 156;
+        x = x * 33 + i + 157;
+        x = x * 33 + i + 158;
+        x = x * 33 + i + 159;
+        x = x * 33 + i + 160;
+        x = x * 33 + i + 161;
+        x = x * 33 + i + 162;
+        x = x * 33 + i + 163;
+        x = x * 33 + i + 164;
+        x = x * 33 + i + 165;
+        x = x * 33 + i + 166;
+        x = x * 33 + i + 167;
+        x = x * 33 + i + 168;
+        x = x * 33 + i + 169;
+        x = x * 33 + i + 170;
+        x = x * 33 + i + 171;
+        x = x * 33 + i + 172;
+        x = x * 33 + i + 173;
+        x = x * 33 + i + 174;
+        x = x * 33 + i + 175;
+        x = x * 33 + i + 176;
+        x = x * 33 + i + 177;
+        x = x * 33 + i + 178;
+        x = x * 33 + i + 179;
+        x = x * 33 + i + 180;
+        x = x * 33 + i + 181;
+        x = x * 33 + i + 182;
+        x = x * 33 + i + 183;
+        x = x * 33 + i + 184;
+        x = x * 33 + i + 185;
+        x = x * 33 + i + 186;
+        x = x * 33 + i + 187;
+        x = x * 33 + i + 188;
+        x = x * 33 + i + 189;
+        x = x * 33 + i + 190;
+        x = x * 33 + i + 191;
+        x = x * 33 + i + 192;
+        x = x * 33 + i + 193;
+        x = x * 33 + i + 194;
+        x = x * 33 + i + 195;
+        x = x * 33 + i + 196;
+        x = x * 33 + i + 197;
+        x = x * 33 + i + 198;
+        x = x * 33 + i + 199;
+        x = x * 33 + i + 200;
+        x = x * 33 + i + 201;
+        x = x * 33 + i + 202;
+        x = x * 33 + i + 203;
+        x = x * 33 + i + 204;
+        x = x * 33 + i + 205;
+        x = x * 33 + i + 206;
+        x = x * 33 + i + 207;
+        x = x * 33 + i + 208;
+        x = x * 33 + i + 209;
+        x = x * 33 + i + 210;
+        x = x * 33 + i + 211;
+        x = x * 33 + i + 212;
+        x = x * 33 + i + 213;
+        x = x * 33 + i + 214;
+        x = x * 33 + i + 215;
+        x = x * 33 + i + 216;
+        x = x * 33 + i + 217;
+        x = x * 33 + i + 218;
+        x = x * 33 + i + 219;
+        x = x * 33 + i + 220;
+        x = x * 33 + i + 221;
+        x = x * 33 + i + 222;
+        x = x * 33 + i + 223;
+        x = x * 33 + i + 224;
+        x = x * 33 + i + 225;
+        x = x * 33 + i + 226;
+        x = x * 33 + i + 227;
+        x = x * 33 + i + 228;
+        x = x * 33 + i + 229;
+        x = x * 33 + i + 230;
+        x = x * 33 + i + 231;
+        x = x * 33 + i + 232;
+        x = x * 33 + i + 233;
+        x = x * 33 + i + 234;
+        x = x * 33 + i + 235;
+        x = x * 33 + i + 236;
+        x = x * 33 + i + 237;
+        x = x * 33 + i + 238;
+        x = x * 33 + i + 239;
+        x = x * 33 + i + 240;
+        x = x * 33 + i + 241;
+        x = x * 33 + i + 242;
+        x = x * 33 + i + 243;
+        x = x * 33 + i + 244;
+        x = x * 33 + i + 245;
+        x = x * 33 + i + 246;
+        x = x * 33 + i + 247;
+        x = x * 33 + i + 248;
+        x = x * 33 + i + 249;
+        x = x * 33 + i + 250;
+        x = x * 33 + i + 251;
+        x = x * 33 + i + 252;
+        x = x * 33 + i + 253;
+        x = x * 33 + i + 254;
+        x = x * 33 + i + 255;
+        x = x * 33 + i + 256;
+        x = x * 33 + i + 257;
+        x = x * 33 + i + 258;
+        x = x * 33 + i + 259;
+        x = x * 33 + i + 260;
+        x = x * 33 + i + 261;
+        x = x * 33 + i + 262;
+        x = x * 33 + i + 263;
+        x = x * 33 + i + 264;
+        x = x * 33 + i + 265;
+        x = x * 33 + i + 266;
+        x = x * 33 + i + 267;
+        x = x * 33 + i + 268;
+        x = x * 33 + i + 269;
+        x = x * 33 + i + 270;
+        x = x * 33 + i + 271;
+        x = x * 33 + i + 272;
+        x = x * 33 + i + 273;
+        x = x * 33 + i + 274;
+        x = x * 33 + i + 275;
+        x = x * 33 + i + 276;
+        x = x * 33 + i + 277;
+        x = x * 33 + i + 278;
+        x = x * 33 + i + 279;
+        x = x * 33 + i + 280;
+        x = x * 33 + i + 281;
+        x = x * 33 + i + 282;
+        x = x * 33 + i + 283;
+        x = x * 33 + i + 284;
+        x = x * 33 + i + 285;
+        x = x * 33 + i + 286;
+        x = x * 33 + i + 287;
+        x = x * 33 + i + 288;
+        x = x * 33 + i + 289;
+        x = x * 33 + i + 290;
+        x = x * 33 + i + 291;
+        x = x * 33 + i + 292;
+        x = x * 33 + i + 293;
+        x = x * 33 + i + 294;
+        x = x * 33 + i + 295;
+        x = x * 33 + i + 296;
+        x = x * 33 + i + 297;
+        x = x * 33 + i + 298;
+        x = x * 33 + i + 299;
+        i++;
+    } while (i < n);
+    return x;
+}
+
+int main() {
+    int i, j, n;
+    float z, f[6];
+    n = sizeof(vals) / sizeof(vals[0]);
+    for (i = 0; i < n; i++) {
+        printf("%d:", vals[i]);
+        for (j = 0; j < n; j++)
+            printf(" %d", cmp(vals[i], vals[j]));
+        printf(" %d\n", cmp_const(vals[i]));
+    }
+    z = 0.0;
+    f[0] = z / z;
+    f[1] = -1.0 / z;
+    f[2] = -1.5;
+    f[3] = -z;
+    f[4] = 2.5;
+    f[5] = 1.0 / z;
+    for (i = 0; i < 6; i++) {
+        for (j = 0; j < 6; j++)
+            printf(" %d", cmpf(f[i], f[j]));
+        printf("\n");
+    }
+    printf("%d %d\n", long_loop(1), long_loop(5));
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+
+int calls;
+
+int f(int v) {
+    ++calls;
+    return v;
+}
+
+// constant conditions with side effects in the operands that don't decide them
+int side_effects() {
+    int r, n;
+    r = 0;
+    n = 0;
+    calls = 0;
+    if (1 || f(1))
+        r |= 1;
+    else
+        r |= 2;
+    if (0 && f(1))
+        r |= 4;
+    else
+        r |= 8;
+    if (f(0) || 1)
+        r |= 16;
+    else
+        r |= 32;
+    if (f(1) && 0)
+        r |= 64;
+    else
+        r |= 128;
+    if (n++ * 0)
+        r |= 256;
+    else
+        r |= 512;
+    if ((n = 5) - 5)
+        r |= 1024;
+    else
+        r |= 2048;
+    r |= (1 ? f(4096) : f(8192));
+    printf("%d %d %d\n", r, n, calls);
+    return 0;
+}
+
+// dead branches a label can enter are kept
+int labels(int x) {
+    int r;
+    r = 0;
+    if (x)
+        goto in_while;
+    while (0) {
+        int k;
+    in_while:
+        k = x * 2;
+        r += k;
+    }
+    if (x > 1)
+        goto in_else;
+    if (1) {
+        r += 100;
+    } else {
+    in_else:
+        r += 1000;
+    }
+    if (0) {
+        r += 10000;
+    in_if:
+        r += 100000;
+    }
+    if (x == 3) {
+        x = 0;
+        goto in_if;
+    }
+    return r;
+}
+
+// dead code a case label can enter is kept too
+int cases(int x) {
+    int r;
+    r = 0;
+    switch (x) {
+    case 0:
+        while (0) {
+        case 1:
+            r += 1;
+        }
+        r += 10;
+        break;
+    case 2:
+        if (0) {
+        case 3:
+            r += 3;
+        } else
+            r += 20;
+        break;
+    }
+    return r;
+}
+
+// dead branches with declarations
+int decls(int x) {
+    int r;
+    r = x;
+    while (0) {
+        int a, b[4];
+        a = f(1);
+        b[0] = a;
+        r = b[0];
+    }
+    if (0) {
+        float g;
+        g = x;
+        r = g * 2.0;
+    } else {
+        int h;
+        h = x + 1;
+        r = r + h;
+    }
+    return r;
+}
+
+int main() {
+    int i;
+    side_effects();
+    for (i = 0; i < 4; i++)
+        printf("%d %d %d\n", labels(i), cases(i), decls(i));
+    return calls != 3;
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+
+// float globals at the start of the data and of the bss, loaded off a base register with a
+// zero or small offset right before they move to a float register
+float ga = 1.5, gb = 2.25, gc = -4.0;
+float za, zb, zc;
+
+int set(float* p, float v) {
+    *p = v;
+    return 0;
+}
+
+int globals() {
+    float s;
+    za = ga * 2.0;
+    zb = gb + za;
+    zc = gc - zb;
+    s = ga + gb + gc + za + zb + zc;
+    s = s * ga - gb / gc;
+    printf("%d %d %d %d\n", (int)(za * 1000), (int)(zb * 1000), (int)(zc * 1000),
+           (int)(s * 1000));
+    return 0;
+}
+
+// float locals kept in the frame, their addresses being taken
+int locals(float x) {
+    float a, b, c, d;
+    set(&a, x);
+    set(&b, x * 2.0);
+    set(&c, -x);
+    set(&d, 0.5);
+    a = a * b + c / d;
+    b = b - a * d;
+    c = a < b ? a : b;
+    printf("%d %d %d %d\n", (int)(a * 1000), (int)(b * 1000), (int)(c * 1000),
+           (int)((a + b + c + d) * 1000));
+    return 0;
+}
+
+int main() {
+    globals();
+    locals(1.0);
+    locals(-3.5);
+    return 0;
+}